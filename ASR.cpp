@@ -13,6 +13,37 @@ C++ Real-Time Audio Programming with Bela - Lecture 14: ADSR
 // ASR.cpp: implement the ASR (attack-sustain-release) class, modified from ADSR example
 
 #include "ASR.h"
+#include <strings.h>
+
+// How far past its level each exponential segment aims, as a fraction of the segment. The attack bends
+// over gently as it nears the sustain level, the release is within -60 dB of silence before it lands
+const float kAttackOvershoot = 0.3f;
+const float kReleaseOvershoot = 0.001f;
+
+static const char* const kEnvelopeCurveNames[kNumEnvelopeCurves] = {"linear", "exponential"};
+static EnvelopeCurve gDefaultEnvelopeCurve = ENVELOPE_CURVE;
+
+const char* envelopeCurveName(EnvelopeCurve curve) {
+	return (curve >= 0 && curve < kNumEnvelopeCurves) ? kEnvelopeCurveNames[curve] : "unknown";
+}
+
+bool parseEnvelopeCurve(const char *name, EnvelopeCurve *curve) {
+	for(int i = 0; i < kNumEnvelopeCurves; i++) {
+		if(strcasecmp(name, kEnvelopeCurveNames[i]) == 0) {
+			*curve = (EnvelopeCurve)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+EnvelopeCurve getDefaultEnvelopeCurve() {
+	return gDefaultEnvelopeCurve;
+}
+
+void setDefaultEnvelopeCurve(EnvelopeCurve curve) {
+	gDefaultEnvelopeCurve = curve;
+}
 
 // Constructor. Set up some default parameters.
 // We can also use initialisation lists before the 
@@ -24,6 +55,7 @@ ASR::ASR()
 	releaseTime_ = 0.001;
 
 	doSustain_ = true;
+	curve_ = ENVELOPE_LINEAR;
 	state_ = StateOff;
 }
 
@@ -38,7 +70,7 @@ void ASR::trigger()
 {
 	if(state_ != StateAttack) { // Moog ignores triggers during attack phase
 		state_ = StateAttack;
-		ramp_.rampTo(sustainLevel_, attackTime_);
+		startSegment(sustainLevel_, attackTime_, kAttackOvershoot);
 	}
 }
 
@@ -47,18 +79,50 @@ void ASR::release()
 {
 	// Go to the Release state from whichever state we were in
 	state_ = StateRelease;
-	ramp_.rampTo(0.0, releaseTime_);
+	startSegment(0.0, releaseTime_, kReleaseOvershoot);
+}
+
+// Start the ramp towards a level, in the shape of the current curve
+void ASR::startSegment(float level, float time, float overshoot)
+{
+	if(curve_ == ENVELOPE_EXPONENTIAL)
+		ramp_.curveTo(level, time, overshoot);
+	else
+		ramp_.rampTo(level, time);
 }
 
 // Calculate the next sample of output, changing the envelope
 // state as needed
 float ASR::process() 
 {
-	// Look at the state we're in to decide what value to return. 
-	// This function handles the outputs within the state but
-	// does not handle the transitions caused by external note events.
-	// Those are done in trigger() and release().
-	
+	updateState();
+    	
+    // Return the current output level
+    return ramp_.process();
+}
+
+// Fill a block of output. Between state changes the ramp either moves
+// for a known number of samples or holds its value, so each span is
+// rendered in one go
+void ASR::processBlock(float *out, int numFrames)
+{
+	int n = 0;
+	while(n < numFrames) {
+		updateState();
+		int span = ramp_.remaining();
+		if(span == 0 || span > numFrames - n) // holding, or ramping past the end of the block
+			span = numFrames - n;
+		ramp_.processBlock(out + n, span);
+		n += span;
+	}
+}
+
+// Look at the state we're in to decide what happens next.
+// This function handles the outputs within the state but
+// does not handle the transitions caused by external note events.
+// Those are done in trigger() and release().
+void ASR::updateState()
+{
    	if(state_ == StateOff) {
 		// Nothing to do here. trigger() will change the state.
 	}
@@ -78,9 +142,6 @@ float ASR::process()
 			state_ = StateOff;
 		}
 	}
-    	
-    // Return the current output level
-    return ramp_.process();
 }
 
 // Indicate whether the envelope is active or not (i.e. in
@@ -122,6 +183,10 @@ void ASR::setSustainMode(bool doSustain) {
 	doSustain_ = doSustain;
 }
 
+void ASR::setCurve(EnvelopeCurve curve) {
+	curve_ = curve;
+}
+
 // Destructor
 ASR::~ASR() 
 {
@@ -11,13 +11,31 @@ C++ Real-Time Audio Programming with Bela - Lecture 14: ADSR
 */
 
 /* ASR.h: header file for defining the ASR class
- * modified from original example code to remove Decay state and make Sustain optional
+ * modified from original example code to remove Decay state and make Sustain optional. The attack and
+ * release are straight lines or, with ENVELOPE_EXPONENTIAL, RC curves like the Moog's envelope generators
  */
 
 #pragma once
 
 #include "Ramp.h"
 
+enum EnvelopeCurve {
+	ENVELOPE_LINEAR = 0, // the original straight segments
+	ENVELOPE_EXPONENTIAL = 1, // attack charging towards a point above the sustain level, release decaying towards zero
+	kNumEnvelopeCurves = 2
+};
+
+#ifndef ENVELOPE_CURVE
+#define ENVELOPE_CURVE ENVELOPE_LINEAR
+#endif
+
+const char* envelopeCurveName(EnvelopeCurve curve);
+bool parseEnvelopeCurve(const char *name, EnvelopeCurve *curve); // accepts "linear" and "exponential", any case
+
+// curve used by voices set up after this is set, ENVELOPE_CURVE until changed
+EnvelopeCurve getDefaultEnvelopeCurve();
+void setDefaultEnvelopeCurve(EnvelopeCurve curve);
+
 class ASR {
 private:
 	// ASR state machine variables, used internally
@@ -48,10 +66,19 @@ public:
 	// state as needed
 	float process(); 
 	
+	// Fill a block of output, same as calling process() numFrames times
+	void processBlock(float *out, int numFrames);
+	
 	// Indicate whether the envelope is active or not (i.e. in
 	// anything other than the Off state
 	bool isActive();
 	
+	// Indicate whether the envelope is still rising towards the sustain level
+	bool isAttacking() { return state_ == StateAttack; }
+	
+	// Return the current output level without advancing
+	float getLevel() { return ramp_.getValue(); }
+	
 	// Methods for getting and setting parameters
 	float getAttackTime() { return attackTime_; }
 	float getSustainLevel() { return sustainLevel_; }
@@ -61,6 +88,8 @@ public:
 	void setSustainLevel(float sustainLevel);
 	void setReleaseTime(float releaseTime);
 	void setSustainMode(bool doSustain);
+	void setCurve(EnvelopeCurve curve); // used from the next segment on
+	EnvelopeCurve getCurve() { return curve_; }
 	
 	// Destructor
 	~ASR();
@@ -72,6 +101,13 @@ private:
 	float releaseTime_;
 	
 	bool doSustain_; //whether or not to skip sustain state
+	EnvelopeCurve curve_;
+	
+	// Start the ramp towards a level, in the shape of the current curve
+	void startSegment(float level, float time, float overshoot);
+	
+	// Apply the state changes that happen when the ramp finishes
+	void updateState();
 	
 	State state_; // Current state of the ASR (one of the enum values above)
 	Ramp ramp_;	// Line segment generator
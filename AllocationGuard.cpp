@@ -0,0 +1,132 @@
+/* AllocationGuard.cpp: malloc and free replacements that report calls from the audio thread
+ * Relies on glibc, which lets a program replace malloc and exports the originals as __libc_malloc etc.
+ */
+#ifdef ALLOCATION_GUARD
+
+#include "AllocationGuard.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <execinfo.h>
+#include <unistd.h>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+static thread_local int tGuardDepth = 0; // > 0 while the thread is inside a Scope
+static AllocationGuardMode gGuardMode = GUARD_ABORT;
+static std::atomic<long> gGuardCount(0);
+
+// write the call and a backtrace to stderr without allocating, then abort or continue
+static void reportAllocation(const char *call, size_t size) {
+	int depth = tGuardDepth;
+	tGuardDepth = 0; // anything the report does itself is not the audio thread's fault
+	gGuardCount++;
+	if(gGuardMode == GUARD_COUNT) {
+		tGuardDepth = depth;
+		return;
+	}
+	char message[96];
+	int length = snprintf(message, sizeof(message), "AllocationGuard: %s(%lu) on the audio thread\n", call, (unsigned long)size);
+	if(write(STDERR_FILENO, message, length) < 0) {}
+	void *frames[32];
+	int numFrames = backtrace(frames, 32);
+	backtrace_symbols_fd(frames, numFrames, STDERR_FILENO);
+	if(gGuardMode == GUARD_ABORT)
+		abort();
+	tGuardDepth = depth;
+}
+
+void AllocationGuard::setup() {
+	// the first backtrace() loads libgcc, which allocates, so do it here rather than in a report
+	void *frames[1];
+	backtrace(frames, 1);
+}
+
+void AllocationGuard::setMode(AllocationGuardMode mode) {
+	gGuardMode = mode;
+}
+
+AllocationGuardMode AllocationGuard::getMode() {
+	return gGuardMode;
+}
+
+long AllocationGuard::getCount() {
+	return gGuardCount.load();
+}
+
+void AllocationGuard::enter() {
+	tGuardDepth++;
+}
+
+void AllocationGuard::leave() {
+	tGuardDepth--;
+}
+
+int AllocationGuard::suspend() {
+	int depth = tGuardDepth;
+	tGuardDepth = 0;
+	return depth;
+}
+
+void AllocationGuard::resume(int depth) {
+	tGuardDepth = depth;
+}
+
+extern "C" {
+
+void *malloc(size_t size) {
+	if(tGuardDepth > 0)
+		reportAllocation("malloc", size);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+	if(tGuardDepth > 0)
+		reportAllocation("calloc", count * size);
+	return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+	if(tGuardDepth > 0)
+		reportAllocation("realloc", size);
+	return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+	if(tGuardDepth > 0)
+		reportAllocation("memalign", size);
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+	if(tGuardDepth > 0)
+		reportAllocation("posix_memalign", size);
+	void *p = __libc_memalign(alignment, size);
+	if(!p)
+		return ENOMEM;
+	*ptr = p;
+	return 0;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+	if(tGuardDepth > 0)
+		reportAllocation("aligned_alloc", size);
+	return __libc_memalign(alignment, size);
+}
+
+void free(void *ptr) {
+	if(ptr && tGuardDepth > 0)
+		reportAllocation("free", 0);
+	__libc_free(ptr);
+}
+
+}
+
+#endif // ALLOCATION_GUARD
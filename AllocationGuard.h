@@ -0,0 +1,51 @@
+/* AllocationGuard.h: debug check that the audio thread never allocates
+ * Built with -DALLOCATION_GUARD, malloc and free are replaced by wrappers that, while the calling thread is inside
+ * render(), print a backtrace and abort (or only log). Without the flag ALLOCATION_GUARD_SCOPE() is empty
+ */
+#pragma once
+
+#ifdef ALLOCATION_GUARD
+
+enum AllocationGuardMode {
+	GUARD_ABORT = 0, // stop at the first allocation, for a debugger or a core dump
+	GUARD_LOG = 1, // print a backtrace for each one and carry on
+	GUARD_COUNT = 2 // only count them, for checking the guard itself
+};
+
+class AllocationGuard {
+public:
+	static void setup(); // call outside the audio thread before the first block
+	static void setMode(AllocationGuardMode mode); // GUARD_ABORT unless changed
+	static AllocationGuardMode getMode();
+	static long getCount(); // allocations and frees caught so far
+
+	// arms the guard on the calling thread while in scope, scopes may nest
+	class Scope {
+	public:
+		Scope() { enter(); }
+		~Scope() { leave(); }
+	};
+
+	// disarms it again, for work that runs on another thread on Bela but inline on the host
+	class Pause {
+	public:
+		Pause() : depth_(suspend()) {}
+		~Pause() { resume(depth_); }
+	private:
+		int depth_;
+	};
+
+private:
+	static void enter();
+	static void leave();
+	static int suspend();
+	static void resume(int depth);
+};
+
+#define ALLOCATION_GUARD_SCOPE() AllocationGuard::Scope allocationGuardScope
+
+#else
+
+#define ALLOCATION_GUARD_SCOPE() ((void)0)
+
+#endif // ALLOCATION_GUARD
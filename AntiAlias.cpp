@@ -0,0 +1,82 @@
+/* AntiAlias.cpp: names of the band-limiting policies and the shared minBLEP table
+ */
+#include "AntiAlias.h"
+#include "Fft.h"
+#include <algorithm>
+#include <cmath>
+#include <strings.h>
+
+static const char* const kAntiAliasNames[kNumAntiAlias] = {"dpw2", "dpw3", "dpw4", "polyblep", "minblep", "wavetable"};
+static AntiAlias gDefaultAntiAlias = ANTI_ALIAS_METHOD;
+
+const char* antiAliasName(AntiAlias method) {
+	return (method >= 0 && method < kNumAntiAlias) ? kAntiAliasNames[method] : "unknown";
+}
+
+bool parseAntiAlias(const char *name, AntiAlias *method) {
+	for(int i = 0; i < kNumAntiAlias; i++) {
+		if(strcasecmp(name, kAntiAliasNames[i]) == 0) {
+			*method = (AntiAlias)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+AntiAlias getDefaultAntiAlias() {
+	return gDefaultAntiAlias;
+}
+
+void setDefaultAntiAlias(AntiAlias method) {
+	gDefaultAntiAlias = method;
+}
+
+const MinBlepTable& MinBlepTable::shared() {
+	static const MinBlepTable table;
+	return table;
+}
+
+// Blackman windowed sinc made minimum phase through the real cepstrum, then integrated into a step
+MinBlepTable::MinBlepTable() {
+	const int length = kLength * kOversampling + 1;
+	const size_t size = 16384; // well above the impulse length, keeps cepstral aliasing low
+	std::vector<std::complex<double> > x(size, 0.0);
+	for(int i = 0; i < length; i++) {
+		double t = (double)i / kOversampling - kZeroCrossings;
+		double sinc = (t == 0.0) ? 1.0 : sin(M_PI * t) / (M_PI * t);
+		double phase = 2.0 * M_PI * i / (length - 1);
+		double window = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2.0 * phase);
+		x[i] = sinc * window;
+	}
+
+	// real cepstrum, folded onto positive quefrencies
+	fft(x, -1);
+	for(size_t i = 0; i < size; i++)
+		x[i] = log(std::max(std::abs(x[i]), 1e-100));
+	fft(x, 1);
+	for(size_t i = 0; i < size; i++)
+		x[i] /= (double)size;
+	for(size_t i = 1; i < size / 2; i++) {
+		x[i] *= 2.0;
+		x[size - i] = 0.0;
+	}
+	x[size / 2] = x[size / 2].real();
+
+	// back to a minimum phase impulse
+	fft(x, -1);
+	for(size_t i = 0; i < size; i++)
+		x[i] = std::exp(x[i]);
+	fft(x, 1);
+
+	// integrate into a step, normalised to end at 1, and keep its difference from the ideal step
+	double sum = 0.0;
+	std::vector<double> step(length);
+	for(int i = 0; i < length; i++) {
+		sum += x[i].real();
+		step[i] = sum;
+	}
+	for(int i = 0; i < length; i++)
+		residual_[i] = (float)(step[i] / sum - 1.0);
+	residual_[length - 1] = 0.0f;
+	residual_[length] = 0.0f;
+}
@@ -0,0 +1,233 @@
+/* AntiAlias.h: interchangeable band-limiting policies for the sawtooth cores
+ * Each policy turns a 32-bit phase (see SubharmonicDivider.h) into a [-1, 1] sawtooth with less aliasing than the
+ * naive ramp. Oscillator and OscillatorBank are templated on them per block, so the choice is made at runtime or,
+ * through ANTI_ALIAS_METHOD, per build. bench/AliasBenchmarks.cpp measures cost and alias rejection of each
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include "SubharmonicDivider.h"
+#include "Wavetable.h"
+
+enum AntiAlias {
+	DPW2 = 0, // differentiated parabolic waveform (Valimaki 2006), the original oscillator
+	DPW3 = 1, // higher order differentiated polynomial waveforms (Valimaki et al. 2010)
+	DPW4 = 2,
+	POLYBLEP = 3, // polynomial band-limited step correction over the sample each side of a wrap
+	MINBLEP = 4, // minimum phase band-limited step (Brandt 2001), tabulated
+	WAVETABLE = 5, // mipmapped single-cycle tables, renders square and the user wave directly, see Wavetable.h
+	kNumAntiAlias = 6
+};
+
+#ifndef ANTI_ALIAS_METHOD
+#define ANTI_ALIAS_METHOD DPW2
+#endif
+
+const char* antiAliasName(AntiAlias method);
+bool parseAntiAlias(const char *name, AntiAlias *method); // accepts the names above, any case
+
+// policy used by voices created after this is set, ANTI_ALIAS_METHOD until changed
+AntiAlias getDefaultAntiAlias();
+void setDefaultAntiAlias(AntiAlias method);
+
+// Every policy has the same interface:
+//   reset(phase, increment): restart at phase, with the history it would have had if it had been running
+//   setIncrement(increment): phase step per sample, call when the frequency changes
+//   process(phase): sample at phase, which has to move on by the increment each call
+
+// DPW of order N: a polynomial of the phase whose (N - 1)th derivative is the sawtooth, differentiated with
+// N - 1 finite differences. Orders above 2 difference values that agree to about dt^(N-1), which float can not
+// resolve at low frequencies, so they run in double
+template<int Order>
+class Dpw {
+public:
+	static_assert(Order >= 2 && Order <= 4, "DPW is implemented for orders 2 to 4");
+	typedef typename std::conditional<Order == 2, float, double>::type real_t;
+
+	void reset(uint32_t phase, uint32_t increment) {
+		setIncrement(increment);
+		for(int i = 0; i < Order - 1; i++)
+			history_[i] = polynomial(phase - (uint32_t)(i + 1) * increment);
+	}
+
+	void setIncrement(uint32_t increment) {
+		// 1 / (N! (2 dt)^(N-1)) restores the amplitude the differences took away
+		real_t twoDt = (real_t)increment * (real_t)(2.0 / 4294967296.0);
+		twoDt = twoDt > 0 ? twoDt : (real_t)1e-9;
+		real_t scale = 1;
+		for(int i = 1; i < Order; i++)
+			scale *= (i + 1) * twoDt;
+		scale_ = 1 / scale;
+	}
+
+	float process(uint32_t phase) {
+		real_t y = polynomial(phase);
+		// (N - 1)th backward difference, binomial weights with alternating signs
+		real_t out = y;
+		real_t binomial = 1;
+		for(int k = 1; k < Order; k++) {
+			binomial = binomial * (Order - k) / k;
+			out += ((k & 1) ? -binomial : binomial) * history_[k - 1];
+		}
+		for(int i = Order - 2; i > 0; i--)
+			history_[i] = history_[i - 1];
+		history_[0] = y;
+		return (float)(out * scale_);
+	}
+
+private:
+	real_t history_[Order - 1]; // previous polynomial values, newest first
+	real_t scale_;
+
+	static real_t polynomial(uint32_t phase) {
+		real_t x = (real_t)(int32_t)(phase ^ 0x80000000u) * (real_t)(1.0 / 2147483648.0);
+		real_t x2 = x * x;
+		if(Order == 2)
+			return x2;
+		if(Order == 3)
+			return x2 * x - x;
+		return x2 * x2 - 2 * x2;
+	}
+};
+
+// naive ramp with the two-sample polynomial residual of a band-limited step subtracted around each wrap
+class PolyBlep {
+public:
+	void reset(uint32_t phase, uint32_t increment) { setIncrement(increment); }
+
+	void setIncrement(uint32_t increment) {
+		dt_ = increment * (1.0f / 4294967296.0f);
+		inverseDt_ = dt_ > 0.0f ? 1.0f / dt_ : 0.0f;
+	}
+
+	float process(uint32_t phase) {
+		float t = phase * (1.0f / 4294967296.0f);
+		float out = bipolarPhase(phase);
+		if(t < dt_) { // just after the wrap
+			float x = t * inverseDt_;
+			out -= x + x - x * x - 1.0f;
+		}
+		else if(t > 1.0f - dt_) { // just before it
+			float x = (t - 1.0f) * inverseDt_;
+			out -= x * x + x + x + 1.0f;
+		}
+		return out;
+	}
+
+private:
+	float dt_;
+	float inverseDt_;
+};
+
+// minimum phase band-limited step residuals, built once and shared by every MinBlep
+class MinBlepTable {
+public:
+	static const int kZeroCrossings = 16;
+	static const int kOversampling = 64;
+	static const int kLength = 2 * kZeroCrossings; // samples of residual after each step
+
+	static const MinBlepTable& shared(); // builds the table on first use, call outside the audio thread
+
+	// residual of a unit step that happened offset samples before output sample index, linear interpolated
+	float residual(int index, float offset) const {
+		float position = (index + offset) * kOversampling;
+		int i = (int)position;
+		float frac = position - i;
+		return residual_[i] + frac * (residual_[i + 1] - residual_[i]);
+	}
+
+private:
+	MinBlepTable();
+	float residual_[kLength * kOversampling + 2]; // minBLEP minus the unit step, padded with a 0 to interpolate to
+};
+
+// naive ramp, adding the minBLEP residual of its -2 step into a short ring of future samples at each wrap
+class MinBlep {
+public:
+	MinBlep() : table_(&MinBlepTable::shared()) {}
+
+	void reset(uint32_t phase, uint32_t increment) {
+		setIncrement(increment);
+		for(int i = 0; i < kRingSize; i++)
+			ring_[i] = 0.0f;
+		index_ = 0;
+		lastPhase_ = phase - increment;
+	}
+
+	void setIncrement(uint32_t increment) {
+		inverseIncrement_ = increment > 0 ? 1.0f / increment : 0.0f;
+	}
+
+	float process(uint32_t phase) {
+		if(phase < lastPhase_) { // wrapped since the last sample, phase / increment samples ago
+			float offset = phase * inverseIncrement_;
+			offset = offset < 1.0f ? offset : 0.999f;
+			for(int i = 0; i < MinBlepTable::kLength; i++)
+				ring_[(index_ + i) & (kRingSize - 1)] -= 2.0f * table_->residual(i, offset);
+		}
+		lastPhase_ = phase;
+		float out = bipolarPhase(phase) + ring_[index_];
+		ring_[index_] = 0.0f;
+		index_ = (index_ + 1) & (kRingSize - 1);
+		return out;
+	}
+
+private:
+	static const int kRingSize = MinBlepTable::kLength; // a power of two
+	const MinBlepTable *table_;
+	float ring_[kRingSize];
+	int index_;
+	uint32_t lastPhase_;
+	float inverseIncrement_;
+};
+
+// maps each AntiAlias value to its policy
+template<AntiAlias Method> struct AntiAliasPolicy;
+template<> struct AntiAliasPolicy<DPW2> { typedef Dpw<2> type; };
+template<> struct AntiAliasPolicy<DPW3> { typedef Dpw<3> type; };
+template<> struct AntiAliasPolicy<DPW4> { typedef Dpw<4> type; };
+template<> struct AntiAliasPolicy<POLYBLEP> { typedef PolyBlep type; };
+template<> struct AntiAliasPolicy<MINBLEP> { typedef MinBlep type; };
+template<> struct AntiAliasPolicy<WAVETABLE> { typedef WavetableCore type; };
+
+// true for policies that read the whole wave from a table rather than building square from two saws
+template<typename Policy> struct IsTabulated : std::false_type {};
+template<> struct IsTabulated<WavetableCore> : std::true_type {};
+
+// state of N cores for every policy, so switching at runtime never allocates
+template<int N>
+class AntiAliasCores {
+public:
+	template<AntiAlias Method>
+	typename AntiAliasPolicy<Method>::type* get() { return std::get<Method>(cores_).data(); }
+
+	// restart core i of one policy
+	void reset(AntiAlias method, int i, uint32_t phase, uint32_t increment) {
+		switch(method) {
+			case DPW2: get<DPW2>()[i].reset(phase, increment); break;
+			case DPW3: get<DPW3>()[i].reset(phase, increment); break;
+			case DPW4: get<DPW4>()[i].reset(phase, increment); break;
+			case POLYBLEP: get<POLYBLEP>()[i].reset(phase, increment); break;
+			case MINBLEP: get<MINBLEP>()[i].reset(phase, increment); break;
+			default: get<WAVETABLE>()[i].reset(phase, increment); break;
+		}
+	}
+
+	void setIncrement(AntiAlias method, int i, uint32_t increment) {
+		switch(method) {
+			case DPW2: get<DPW2>()[i].setIncrement(increment); break;
+			case DPW3: get<DPW3>()[i].setIncrement(increment); break;
+			case DPW4: get<DPW4>()[i].setIncrement(increment); break;
+			case POLYBLEP: get<POLYBLEP>()[i].setIncrement(increment); break;
+			case MINBLEP: get<MINBLEP>()[i].setIncrement(increment); break;
+			default: get<WAVETABLE>()[i].setIncrement(increment); break;
+		}
+	}
+
+private:
+	std::tuple<std::array<Dpw<2>, N>, std::array<Dpw<3>, N>, std::array<Dpw<4>, N>,
+		std::array<PolyBlep, N>, std::array<MinBlep, N>, std::array<WavetableCore, N> > cores_;
+};
@@ -0,0 +1,65 @@
+/* ControlInput.cpp: implements scaling and smoothing of analog controls
+ */
+#include "ControlInput.h"
+#include <cmath>
+
+ControlInput::ControlInput(float inMin, float inMax, float outMin, float outMax) {
+	setup(inMin, inMax, outMin, outMax);
+}
+
+void ControlInput::setup(float inMin, float inMax, float outMin, float outMax) {
+	inMin_ = inMin;
+	inMax_ = inMax;
+	outMin_ = outMin;
+	outMax_ = outMax;
+	current_ = outMin;
+	primed_ = false;
+}
+
+void ControlInput::setSmoothing(Smoothing type, float audioSampleRate, float time) {
+	type_ = type;
+	// reach 63% of a step after time seconds
+	if(time > 0.0f)
+		coefficient_ = 1.0f - expf(-1.0f / (time * audioSampleRate));
+	else
+		coefficient_ = 1.0f;
+}
+
+void ControlInput::processBlock(float *out, const float *raw, int numControlFrames, int framesPerControlFrame) {
+	for(int k = 0; k < numControlFrames; k++) {
+		// same scaling as Bela's map(), evaluated once per analog frame
+		float target = (raw[k] - inMin_) * (outMax_ - outMin_) / (inMax_ - inMin_) + outMin_;
+		if(!primed_) {
+			current_ = target;
+			primed_ = true;
+		}
+		float *frame = out + k * framesPerControlFrame;
+		
+		if(type_ == SMOOTH_NONE || target == current_) {
+			// hold, also the settled case for the smoothers
+			current_ = target;
+			for(int n = 0; n < framesPerControlFrame; n++)
+				frame[n] = target;
+		}
+		else if(type_ == SMOOTH_LINEAR) {
+			float increment = (target - current_) / framesPerControlFrame;
+			for(int n = 0; n < framesPerControlFrame - 1; n++) {
+				current_ += increment;
+				frame[n] = current_;
+			}
+			current_ = target; // land exactly on the new value
+			frame[framesPerControlFrame - 1] = target;
+		}
+		else { // SMOOTH_ONE_POLE
+			float value = current_;
+			for(int n = 0; n < framesPerControlFrame; n++) {
+				value += coefficient_ * (target - value);
+				frame[n] = value;
+			}
+			// snap once the remaining step is inaudible, so later frames take the hold path
+			if(fabsf(target - value) <= 1e-6f * fabsf(target))
+				value = target;
+			current_ = value;
+		}
+	}
+}
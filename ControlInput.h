@@ -0,0 +1,36 @@
+/* ControlInput.h: one analog control, scaled once per analog frame and smoothed to audio rate
+ */
+#pragma once
+
+enum Smoothing {
+	SMOOTH_NONE = 0, // hold each analog frame, same as reading the input every audio frame
+	SMOOTH_LINEAR = 1, // ramp to each new analog value over one analog frame
+	SMOOTH_ONE_POLE = 2 // exponential approach with a configurable time constant
+};
+
+class ControlInput {
+public:
+	ControlInput() {} // Default constructor
+	ControlInput(float inMin, float inMax, float outMin, float outMax);
+	
+	void setup(float inMin, float inMax, float outMin, float outMax); // input range mapped to output range
+	void setSmoothing(Smoothing type, float audioSampleRate, float time = 0.0f); // time constant in seconds, one-pole only
+	
+	// Scale numControlFrames raw analog values and write framesPerControlFrame audio rate values for each
+	void processBlock(float *out, const float *raw, int numControlFrames, int framesPerControlFrame);
+	
+	float getValue() { return current_; } // latest smoothed value
+	
+	~ControlInput() {} // Destructor
+
+private:
+	float inMin_;
+	float inMax_;
+	float outMin_;
+	float outMax_;
+	
+	Smoothing type_ = SMOOTH_NONE;
+	float coefficient_; // one-pole coefficient per audio frame
+	float current_; // smoothed output
+	bool primed_ = false; // start from the first value read rather than ramping from zero
+};
@@ -0,0 +1,183 @@
+/* CpuProfiler.cpp: ring buffer, histograms and reports for the render() profiler
+ */
+#ifdef CPU_PROFILE
+
+#include "CpuProfiler.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+static double monotonicNs() {
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CpuHistogram::add(float load) {
+	int bin = 0;
+	if(load > kMinLoad)
+		bin = (int)(kBinsPerOctave * log2f(load / kMinLoad));
+	if(bin >= kNumBins)
+		bin = kNumBins - 1;
+	bins_[bin]++;
+	count_++;
+	sum_ += load;
+	if(load > max_)
+		max_ = load;
+}
+
+void CpuHistogram::reset() {
+	for(int i = 0; i < kNumBins; i++)
+		bins_[i] = 0;
+	count_ = 0;
+	sum_ = 0.0;
+	max_ = 0.0f;
+}
+
+float CpuHistogram::binEdge(int bin) {
+	return kMinLoad * exp2f((bin + 1) / (float)kBinsPerOctave);
+}
+
+float CpuHistogram::getPercentile(float p) const {
+	if(count_ == 0)
+		return 0.0f;
+	long target = (long)ceil(p * count_);
+	long seen = 0;
+	for(int i = 0; i < kNumBins; i++) {
+		seen += bins_[i];
+		if(seen >= target)
+			return fminf(binEdge(i), max_); // never report more than was seen
+	}
+	return max_;
+}
+
+void CpuProfiler::setup(float sampleRate, int blockSize) {
+	// measure the counter rate against the clock, refined on every collect()
+	calibrationTicks_ = readTicks();
+	calibrationNs_ = monotonicNs();
+	calibrating_ = true;
+	double start = calibrationNs_;
+	while(monotonicNs() - start < 20e6) {}
+	calibrate();
+
+	deadlineUs_ = 1e6 * blockSize / sampleRate;
+	deadlineTicks_ = deadlineUs_ * 1000.0 * ticksPerNs_;
+	windowBlocks_ = (int)(sampleRate / blockSize);
+	if(windowBlocks_ < 1)
+		windowBlocks_ = 1;
+	for(int i = 0; i <= kNumProfileStages; i++) {
+		window_[i].reset();
+		total_[i].reset();
+	}
+	windowXruns_ = totalXruns_ = 0;
+}
+
+void CpuProfiler::calibrate() {
+	uint64_t cycles;
+	if(!readCycleCounter(cycles)) {
+		ticksPerNs_ = 1.0; // ticks are already nanoseconds
+		return;
+	}
+	double elapsedNs = monotonicNs() - calibrationNs_;
+	if(elapsedNs > 1e9) { // known well enough by now, and the 32 bit ARM counter could wrap twice
+		calibrating_ = false;
+		return;
+	}
+	// within a second the difference fits in 32 bits on either counter
+	ticksPerNs_ = (double)(uint32_t)(readTicks() - calibrationTicks_) / elapsedNs;
+}
+
+void CpuProfiler::endBlock() {
+	uint32_t write = writeIndex_.load(std::memory_order_relaxed);
+	if(write - readIndex_.load(std::memory_order_acquire) >= kRingSize) {
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	ring_[write & (kRingSize - 1)] = current_;
+	writeIndex_.store(write + 1, std::memory_order_release);
+}
+
+bool CpuProfiler::collect() {
+	if(calibrating_) {
+		calibrate();
+		deadlineTicks_ = deadlineUs_ * 1000.0 * ticksPerNs_;
+	}
+
+	uint32_t read = readIndex_.load(std::memory_order_relaxed);
+	uint32_t write = writeIndex_.load(std::memory_order_acquire);
+	bool windowDone = false;
+	for(; read != write; read++) {
+		const Record& record = ring_[read & (kRingSize - 1)];
+		double blockTicks = 0.0;
+		for(int i = 0; i < kNumProfileStages; i++) {
+			blockTicks += record.ticks[i];
+			float load = record.ticks[i] / deadlineTicks_;
+			window_[i].add(load);
+			total_[i].add(load);
+		}
+		float load = blockTicks / deadlineTicks_;
+		window_[kNumProfileStages].add(load);
+		total_[kNumProfileStages].add(load);
+		if(load > 1.0f) {
+			windowXruns_++;
+			totalXruns_++;
+		}
+		if(window_[kNumProfileStages].getCount() >= windowBlocks_)
+			windowDone = true;
+	}
+	readIndex_.store(read, std::memory_order_release);
+	return windowDone;
+}
+
+void CpuProfiler::getReport(float *report) const {
+	report[0] = windowXruns_;
+	report[1] = dropped_.load(std::memory_order_relaxed);
+	report[2] = window_[kNumProfileStages].getCount();
+	for(int i = 0; i <= kNumProfileStages; i++) {
+		// whole block first, then the stages in order
+		const CpuHistogram& h = window_[(i + kNumProfileStages) % (kNumProfileStages + 1)];
+		report[3 + 3 * i] = 100.0f * h.getMean();
+		report[4 + 3 * i] = 100.0f * h.getPercentile(0.99f);
+		report[5 + 3 * i] = 100.0f * h.getMax();
+	}
+}
+
+void CpuProfiler::startWindow() {
+	for(int i = 0; i <= kNumProfileStages; i++)
+		window_[i].reset();
+	windowXruns_ = 0;
+}
+
+const char* CpuProfiler::stageName(int stage) {
+	static const char *names[kNumProfileStages + 1] = {
+		"controls", "sequencing", "oscillators", "filter coefficients", "filter", "output", "block"
+	};
+	return names[stage];
+}
+
+bool CpuProfiler::writeReport(const char *path) const {
+	FILE *f = fopen(path, "w");
+	if(!f)
+		return false;
+	fprintf(f, "{\n  \"deadline_us\": %g,\n  \"blocks\": %ld,\n  \"xruns\": %ld,\n  \"dropped\": %u,\n  \"stages\": [\n",
+		deadlineUs_, total_[kNumProfileStages].getCount(), totalXruns_, dropped_.load(std::memory_order_relaxed));
+	for(int i = 0; i <= kNumProfileStages; i++) {
+		const CpuHistogram& h = total_[i];
+		fprintf(f, "    {\"name\": \"%s\", \"mean_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f, \"mean_load\": %.5f, \"p99_load\": %.5f, \"max_load\": %.5f,\n",
+			stageName(i), h.getMean() * deadlineUs_, h.getPercentile(0.99f) * deadlineUs_, h.getMax() * deadlineUs_,
+			h.getMean(), h.getPercentile(0.99f), h.getMax());
+		// bins as [upper edge in share of the deadline, blocks], empty ones left out
+		fprintf(f, "     \"histogram\": [");
+		bool first = true;
+		for(int b = 0; b < CpuHistogram::kNumBins; b++) {
+			if(h.getBins()[b] == 0)
+				continue;
+			fprintf(f, "%s[%.5g, %u]", first ? "" : ", ", CpuHistogram::binEdge(b), h.getBins()[b]);
+			first = false;
+		}
+		fprintf(f, "]}%s\n", i < kNumProfileStages ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	fclose(f);
+	return true;
+}
+
+#endif // CPU_PROFILE
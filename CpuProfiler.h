@@ -0,0 +1,129 @@
+/* CpuProfiler.h: per-stage CPU time of render() against the block deadline
+ * The audio thread reads the cycle counter between stages and pushes one record per block into a lock-free
+ * ring. An auxiliary task drains the ring into histograms of each stage's share of the deadline (mean, p99,
+ * max) and counts blocks that went over it. Only built with -DCPU_PROFILE, otherwise the PROFILE_ macros
+ * expand to nothing
+ */
+#pragma once
+
+#ifdef CPU_PROFILE
+
+#include <atomic>
+#include <cstdint>
+#include "CycleCounter.h"
+
+enum ProfileStage {
+	STAGE_CONTROLS = 0, // GUI snapshot, analog inputs and buttons
+	STAGE_SEQUENCING = 1, // events, envelopes and oscillator pitch
+	STAGE_OSCILLATORS = 2,
+	STAGE_FILTER_COEFFS = 3, // cutoff envelopes
+	STAGE_FILTER = 4,
+	STAGE_OUTPUT = 5, // voice mix, audio out and scope
+	kNumProfileStages = 6
+};
+
+// share of the block deadline on log spaced bins, 8 per octave from 1/16384 of the deadline to 4 times it
+class CpuHistogram {
+public:
+	static const int kBinsPerOctave = 8;
+	static const int kNumBins = 16 * kBinsPerOctave;
+	static constexpr float kMinLoad = 1.0f / 16384.0f;
+
+	CpuHistogram() { reset(); }
+
+	void add(float load);
+	void reset();
+
+	long getCount() const { return count_; }
+	float getMean() const { return count_ > 0 ? sum_ / count_ : 0.0f; }
+	float getMax() const { return max_; }
+	float getPercentile(float p) const; // upper edge of the bin holding the p-th fraction of blocks
+
+	const uint32_t* getBins() const { return bins_; }
+	static float binEdge(int bin); // upper edge of a bin
+
+private:
+	uint32_t bins_[kNumBins];
+	long count_;
+	double sum_;
+	float max_;
+};
+
+class CpuProfiler {
+public:
+	static const int kRingSize = 1024; // blocks, a power of two
+	static const int kReportSize = 3 + 3 * (kNumProfileStages + 1); // floats filled by getReport()
+
+	CpuProfiler() {} // Default constructor
+
+	void setup(float sampleRate, int blockSize); // measures the counter rate, call before the first block
+
+	// audio thread: time each stage since the previous mark, stages may be marked more than once per block
+	void beginBlock() {
+		for(int i = 0; i < kNumProfileStages; i++)
+			current_.ticks[i] = 0;
+		last_ = readTicks();
+	}
+	void mark(ProfileStage stage) {
+		uint64_t now = readTicks();
+		current_.ticks[stage] += (uint32_t)(now - last_);
+		last_ = now;
+	}
+	void endBlock();
+
+	// aggregating thread: move new blocks into the histograms, returns true once per report window
+	bool collect();
+
+	// [xruns, dropped records, blocks, then mean, p99 and max in percent of the deadline for the whole
+	// block and each stage] for the last window
+	void getReport(float *report) const;
+	void startWindow(); // clear the window statistics once reported
+
+	// totals since setup as JSON, including the histograms
+	bool writeReport(const char *path) const;
+
+	static const char* stageName(int stage);
+
+	~CpuProfiler() {} // Destructor
+
+private:
+	struct Record {
+		uint32_t ticks[kNumProfileStages];
+	};
+
+	// audio thread state
+	Record current_;
+	uint64_t last_;
+
+	// single producer, single consumer ring of finished blocks
+	Record ring_[kRingSize];
+	std::atomic<uint32_t> writeIndex_{0};
+	std::atomic<uint32_t> readIndex_{0};
+	std::atomic<uint32_t> dropped_{0}; // blocks lost to a full ring
+
+	// aggregating thread state
+	double deadlineTicks_; // one block period
+	double deadlineUs_;
+	int windowBlocks_; // blocks per report, about a second
+	uint64_t calibrationTicks_; // counter and clock at setup, to refine the counter rate over the first second
+	double calibrationNs_;
+	double ticksPerNs_;
+	bool calibrating_;
+	CpuHistogram window_[kNumProfileStages + 1]; // whole block last
+	CpuHistogram total_[kNumProfileStages + 1];
+	long windowXruns_, totalXruns_;
+
+	void calibrate();
+};
+
+#define PROFILE_BEGIN(profiler) (profiler).beginBlock()
+#define PROFILE_MARK(profiler, stage) (profiler).mark(stage)
+#define PROFILE_END(profiler) (profiler).endBlock()
+
+#else
+
+#define PROFILE_BEGIN(profiler) ((void)0)
+#define PROFILE_MARK(profiler, stage) ((void)0)
+#define PROFILE_END(profiler) ((void)0)
+
+#endif // CPU_PROFILE
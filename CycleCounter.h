@@ -0,0 +1,37 @@
+/* CycleCounter.h: CPU cycle counter shared by the profiler and the benchmarks
+ * x86 always has one. On the BeagleBone the Cortex-A8 counter can only be read from user space once the kernel
+ * has enabled it, so it is opt-in with -DUSE_ARM_PMU
+ */
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// read the CPU cycle counter, returns false where no user space counter is available
+static inline bool readCycleCounter(uint64_t& cycles) {
+#if defined(__x86_64__) || defined(__i386__)
+	cycles = __rdtsc();
+	return true;
+#elif defined(__arm__) && defined(USE_ARM_PMU)
+	uint32_t ccnt;
+	asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r"(ccnt));
+	cycles = ccnt; // 32 bits, wraps every few seconds, fine for timing a block
+	return true;
+#else
+	cycles = 0;
+	return false;
+#endif
+}
+
+// cycle count where there is a counter, monotonic nanoseconds otherwise
+static inline uint64_t readTicks() {
+	uint64_t cycles;
+	if(readCycleCounter(cycles))
+		return cycles;
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
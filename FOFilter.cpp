@@ -29,33 +29,53 @@ FOFilter::FOFilter(float sampleRate, float frequencyHz, float resonance) {
 void FOFilter::calculate_coefficients(float sampleRate, float frequencyHz, float resonance) {
 	float wc = 2.0f * M_PI * frequencyHz / sampleRate; // convert Hz to angular digital frequency
 	
-	// adjust cutoff to get desired measured cutoff frequency, polynomial approximation
-	float g = 0.9892 * wc - 0.4342 * powf(wc, 2.0f) + 0.1381 * powf(wc, 3.0f) - 0.0202 * powf(wc, 4.0f);
+	// adjust cutoff to get desired measured cutoff frequency
+	float g = cutoffGain(wc);
 	
 	// calculate IIR coefficients
 	B0_ = g * 1.0f / 1.3f;
 	B1_ = g * 0.3f / 1.3f;
 	A1_ = -(1.0f - g);
 	
-	// calculate resonance parameter using polynomial approximation
-	GRes_ = resonance * (1.0029 + 0.0526 * wc - 0.0926 * powf(wc,2.0f) + 0.218 * powf(wc, 3.0f));
+	// calculate resonance parameter
+	GRes_ = resonance * resonanceScale(wc);
 }
-	
-float FOFilter::process(float in) {
-	//push one sample through IIR filter
-	float out = B0_ * in + B1_ * X1_ - A1_ * Y1_;
-	
-	//remember states for next iteration
-	X1_ = in;
-	Y1_ = out;
-	
-	return out;
+
+// Set coefficients computed elsewhere, e.g. shared by all sections of a ladder
+void FOFilter::setCoefficients(float b0, float b1, float a1, float gRes) {
+	B0_ = b0;
+	B1_ = b1;
+	A1_ = a1;
+	GRes_ = gRes;
 }
 
-float FOFilter::getY1() {
-	return Y1_;
+// cutoff correction to get desired measured cutoff frequency, polynomial approximation
+float FOFilter::cutoffGain(float wc) {
+	return wc * (0.9892f + wc * (-0.4342f + wc * (0.1381f - 0.0202f * wc))); // Horner form, no powf
+}
+
+// resonance correction using polynomial approximation
+float FOFilter::resonanceScale(float wc) {
+	return 1.0029f + wc * (0.0526f + wc * (-0.0926f + 0.218f * wc));
+}
+
+
+void FOFilter::processBlock(float *out, const float *in, int numFrames) {
+	float x1 = X1_;
+	float y1 = Y1_;
+	for(int n = 0; n < numFrames; n++) {
+		float x = in[n];
+		y1 = B0_ * x + B1_ * x1 - A1_ * y1;
+		x1 = x;
+		out[n] = y1;
+	}
+	X1_ = x1;
+	Y1_ = y1;
 }
 
-float FOFilter::getGRes() {
-	return GRes_;
+void FOFilter::flushState(float threshold) {
+	if(fabsf(X1_) < threshold)
+		X1_ = 0.0f;
+	if(fabsf(Y1_) < threshold)
+		Y1_ = 0.0f;
 }
\ No newline at end of file
@@ -4,7 +4,6 @@
 
 #pragma once
 
-#include <vector>
 
 class FOFilter {
 public:
@@ -12,12 +11,19 @@ public:
 	FOFilter(float sampleRate, float frequencyHz, float resonance); // Constructor with arguments to initialize filter
 	
 	void calculate_coefficients(float sampleRate, float frequencyHz, float resonance); // Set parameters
+	void setCoefficients(float b0, float b1, float a1, float gRes); // Set precomputed coefficients
 	
-	float process(float in); // Get the next sample and update state variables
+	static float cutoffGain(float wc); // polynomial cutoff correction g for angular frequency wc
+	static float resonanceScale(float wc); // polynomial resonance correction, scaled by the resonance
 	
-	float getY1(); // return y[n-1]
+	float process(float in); // Get the next sample and update state variables, inline so a ladder unrolls
+	void processBlock(float *out, const float *in, int numFrames); // Filter a block, out may equal in
 	
-	float getGRes(); // return filter resonance
+	float getY1() { return Y1_; } // return y[n-1]
+	
+	void flushState(float threshold); // zero state variables below threshold so a decayed tail never goes denormal
+	
+	float getGRes() { return GRes_; } // return filter resonance
 	
 	~FOFilter() {} // Destructor
 
@@ -31,3 +37,14 @@ private:
 	float X1_;
 	float Y1_;
 };
+
+inline float FOFilter::process(float in) {
+	//push one sample through IIR filter
+	float out = B0_ * in + B1_ * X1_ - A1_ * Y1_;
+	
+	//remember states for next iteration
+	X1_ = in;
+	Y1_ = out;
+	
+	return out;
+}
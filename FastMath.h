@@ -0,0 +1,76 @@
+/* FastMath.h: polynomial exp2, log2, pow and tanh for floats and float vectors
+ * One algorithm per function, written against the backends of Simd.h so a float, an SSE2 or AVX2 register and a
+ * NEON register all get the same approximation. Replaces libm in the audio path and Bela's tanhf_neon, so the
+ * filters build and run the same on x86. Bounds over the whole range of each function, measured against double
+ * precision libm by the FastMath:: benchmarks, which fail a case that exceeds them:
+ *   fastExp2(x)    relative 2.5e-7, x clamped to [-126, 126]
+ *   fastLog2(x)    absolute 2.5e-7 (relative 2.5e-7 near x = 1), x positive and normal
+ *   fastPow(x, y)  relative 2.5e-7 * (1 + |y log2 x|), x positive and normal
+ *   fastTanh(x)    absolute 2.5e-7, relative 3e-7
+ */
+#pragma once
+
+#include "Simd.h"
+
+// minimax polynomials, lowest order first
+const float kFastExp2Poly[6] = {1.00000007f, 0.693146967f, 0.240221197f, 0.0555071327f, 0.00967554133f, 0.00132764722f}; // 2^f, |f| <= 0.5
+const float kFastLog2Poly[8] = {1.44269492f, -0.721352487f, 0.480931162f, -0.360263462f, 0.286868877f, -0.248322808f,
+	0.235709636f, -0.149733278f}; // log2(1 + t) / t, sqrt(0.5) <= 1 + t < sqrt(2)
+const float kFastTanhPoly[5] = {0.999999987f, -0.333330694f, 0.133247793f, -0.0529860753f, 0.0171350066f}; // tanh(x) / x in x^2, |x| < 0.5
+
+template<typename V, int N>
+inline V fastHorner(V x, const float (&c)[N]) {
+	V sum = V::splat(c[N - 1]);
+	for(int i = N - 2; i >= 0; i--)
+		sum = V::add(V::mul(sum, x), V::splat(c[i]));
+	return sum;
+}
+
+// 2^x from 2^round(x), built in the exponent bits, times a polynomial for the fraction
+template<typename V>
+inline V fastExp2(V x) {
+	x = V::min(V::max(x, V::splat(-126.0f)), V::splat(126.0f));
+	V n = V::round(x);
+	return V::mul(fastHorner(V::sub(x, n), kFastExp2Poly), V::pow2i(n));
+}
+
+// exponent plus log2 of the mantissa, moved into [sqrt(0.5), sqrt(2)) so the polynomial stays short
+template<typename V>
+inline V fastLog2(V x) {
+	V exponent;
+	V m = V::split(x, exponent);
+	typename V::mask_t high = V::less(V::splat(1.41421356f), m);
+	m = V::select(high, V::mul(m, V::splat(0.5f)), m);
+	exponent = V::select(high, V::add(exponent, V::splat(1.0f)), exponent);
+	V t = V::sub(m, V::splat(1.0f));
+	return V::add(exponent, V::mul(t, fastHorner(t, kFastLog2Poly)));
+}
+
+template<typename V>
+inline V fastPow(V x, V y) {
+	return fastExp2(V::mul(y, fastLog2(x)));
+}
+
+// odd polynomial near zero, where 1 - 2 / (e^2x + 1) would lose the small result to cancellation
+template<typename V>
+inline V fastTanh(V x) {
+	V a = V::abs(x);
+	V small = V::mul(x, fastHorner(V::mul(x, x), kFastTanhPoly));
+	V e2x = fastExp2(V::mul(V::min(a, V::splat(9.0f)), V::splat(2.88539008f))); // 2 log2(e), tanh(9) rounds to 1
+	V large = V::sub(V::splat(1.0f), V::div(V::splat(2.0f), V::add(e2x, V::splat(1.0f))));
+	large = V::select(V::less(x, V::splat(0.0f)), V::sub(V::splat(0.0f), large), large);
+	return V::select(V::less(a, V::splat(0.5f)), small, large);
+}
+
+// the same for scalar code
+inline float fastExp2(float x) { return fastExp2(SimdScalar{x}).v; }
+inline float fastLog2(float x) { return fastLog2(SimdScalar{x}).v; }
+inline float fastPow(float x, float y) { return fastPow(SimdScalar{x}, SimdScalar{y}).v; }
+inline float fastTanh(float x) { return fastTanh(SimdScalar{x}).v; }
+
+// nearest integer, halves away from zero like round()
+inline int fastRoundToInt(float x) {
+	int i = (int)x;
+	float r = x - (float)i;
+	return i + (r >= 0.5f ? 1 : 0) - (r <= -0.5f ? 1 : 0);
+}
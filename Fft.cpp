@@ -0,0 +1,30 @@
+/* Fft.cpp: implements the table building FFT
+ */
+#include "Fft.h"
+#include <cmath>
+#include <utility>
+
+void fft(std::vector<std::complex<double> >& x, int sign) {
+	const size_t n = x.size();
+	for(size_t i = 1, j = 0; i < n; i++) {
+		size_t bit = n >> 1;
+		for(; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if(i < j)
+			std::swap(x[i], x[j]);
+	}
+	for(size_t len = 2; len <= n; len <<= 1) {
+		std::complex<double> w = std::polar(1.0, sign * 2.0 * M_PI / len);
+		for(size_t i = 0; i < n; i += len) {
+			std::complex<double> wk = 1.0;
+			for(size_t k = 0; k < len / 2; k++) {
+				std::complex<double> a = x[i + k];
+				std::complex<double> b = x[i + k + len / 2] * wk;
+				x[i + k] = a + b;
+				x[i + k + len / 2] = a - b;
+				wk *= w;
+			}
+		}
+	}
+}
@@ -0,0 +1,9 @@
+/* Fft.h: small radix-2 FFT for building tables at startup, not meant for the audio thread
+ */
+#pragma once
+
+#include <complex>
+#include <vector>
+
+// in place transform of a power of two length, forward when sign is -1, inverse (unscaled) when +1
+void fft(std::vector<std::complex<double> >& x, int sign);
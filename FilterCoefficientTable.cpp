@@ -0,0 +1,49 @@
+/* FilterCoefficientTable.cpp: implements the shared ladder coefficient table
+ */
+#include "FilterCoefficientTable.h"
+#include "FOFilter.h"
+#include <cmath>
+
+const FilterCoefficientTable& FilterCoefficientTable::shared() {
+	static const FilterCoefficientTable table;
+	return table;
+}
+
+FilterCoefficientTable::FilterCoefficientTable() {
+	for(int i = 0; i <= kNumPoints; i++) {
+		float wc = 2.0f * M_PI * (0.5f * i / kNumPoints); // angular frequency of this point
+		table_[2 * i] = FOFilter::cutoffGain(wc);
+		table_[2 * i + 1] = FOFilter::resonanceScale(wc);
+		// tan() runs off to infinity at Nyquist, where the gain tends to 1
+		double g = tan(M_PI * 0.5 * i / kNumPoints);
+		prewarp_[i] = (i == kNumPoints) ? 1.0f : (float)(g / (1.0 + g));
+	}
+}
+
+// clamp to the table, the last interval is used for the upper edge
+static inline int tablePosition(float normalizedCutoff, int numPoints, float& frac) {
+	float position = normalizedCutoff * (2.0f * numPoints);
+	if(position < 0.0f)
+		position = 0.0f;
+	else if(position > numPoints)
+		position = numPoints;
+	int index = (int)position;
+	if(index >= numPoints)
+		index = numPoints - 1;
+	frac = position - index;
+	return index;
+}
+
+void FilterCoefficientTable::lookup(float normalizedCutoff, float& g, float& resonanceScale) const {
+	float frac;
+	int index = tablePosition(normalizedCutoff, kNumPoints, frac);
+	const float *p = table_ + 2 * index;
+	g = p[0] + frac * (p[2] - p[0]);
+	resonanceScale = p[1] + frac * (p[3] - p[1]);
+}
+
+float FilterCoefficientTable::prewarpedGain(float normalizedCutoff) const {
+	float frac;
+	int index = tablePosition(normalizedCutoff, kNumPoints, frac);
+	return prewarp_[index] + frac * (prewarp_[index + 1] - prewarp_[index]);
+}
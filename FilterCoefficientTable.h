@@ -0,0 +1,25 @@
+/* FilterCoefficientTable.h: precomputed ladder section coefficients indexed by normalized cutoff
+ * Built once and shared by every ResFilter, so cutoff sweeps cost a table lookup instead of
+ * evaluating the FOFilter polynomials with powf for each section. Also holds the tan prewarped gain
+ * of the zero-delay-feedback sections, see ResFilterBank.h
+ */
+#pragma once
+
+class FilterCoefficientTable {
+public:
+	static const int kNumPoints = 2048; // intervals over normalized cutoff [0, 0.5]
+
+	// table shared by all filters, built on first use (call from setup, not render)
+	static const FilterCoefficientTable& shared();
+
+	// interpolated cutoff gain g and resonance scaling for cutoff / sampleRate in [0, 0.5]
+	void lookup(float normalizedCutoff, float& g, float& resonanceScale) const;
+	// interpolated g / (1 + g) with g = tan(pi * cutoff / sampleRate), the gain of a TPT one-pole section
+	float prewarpedGain(float normalizedCutoff) const;
+
+private:
+	FilterCoefficientTable(); // fills the table from the FOFilter polynomials
+
+	float table_[(kNumPoints + 1) * 2]; // interleaved {g, resonanceScale} per point
+	float prewarp_[kNumPoints + 1];
+};
@@ -0,0 +1,56 @@
+/* GuiProtocol.cpp: implements decoding of GUI parameter packets
+ */
+#include "GuiProtocol.h"
+#include <atomic>
+
+bool GuiProtocol::decode(const float *packet, int size, ParameterStore& store) {
+	if(size < kHeaderSize + 1)
+		return false;
+	float client = packet[0];
+	float version = packet[1];
+	if(!(client >= 1.0f && client < kMaxVersion) || client != (int)client || !(version >= 1.0f && version < kMaxVersion))
+		return false; // nothing sent yet
+	if(client == (float)client_ && version == (float)version_)
+		return false; // already applied
+	float count = packet[2];
+	if(!(count >= 0.0f && count <= store.getNumParams()) || count != (int)count)
+		return false;
+	int numPairs = (int)count;
+	if(kHeaderSize + 2 * numPairs + 1 > size)
+		return false;
+	
+	// read back to front of the order the packet is written in, so a rewrite that overlaps
+	// this copy changes the trailing version or the header and the packet is rejected
+	float trailer = packet[kHeaderSize + 2 * numPairs];
+	std::atomic_thread_fence(std::memory_order_acquire);
+	for(int i = 0; i < numPairs; i++) {
+		float id = packet[kHeaderSize + 2 * i];
+		if(!(id >= 0.0f && id < store.getNumParams()))
+			return false;
+		ids_[i] = (int)id;
+		values_[i] = packet[kHeaderSize + 2 * i + 1];
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if(packet[1] != trailer || packet[2] != count || packet[0] != client)
+		return false;
+	
+	for(int i = 0; i < numPairs; i++) {
+		store.set(ids_[i], values_[i]);
+	}
+	store.publish();
+	client_ = (int)client;
+	version_ = (int)version;
+	return true;
+}
+
+int GuiProtocol::encode(float *packet, int client, int version, const int *ids, const float *values, int count) {
+	packet[0] = client;
+	packet[1] = version;
+	packet[2] = count;
+	for(int i = 0; i < count; i++) {
+		packet[kHeaderSize + 2 * i] = ids[i];
+		packet[kHeaderSize + 2 * i + 1] = values[i];
+	}
+	packet[kHeaderSize + 2 * count] = version;
+	return kHeaderSize + 2 * count + 1;
+}
@@ -0,0 +1,43 @@
+/* GuiProtocol.h: packets of changed GUI parameters sent by sketch.js
+ * A packet is [client, version, count, id, value, id, value, ..., version]. The browser sends every change the synth
+ * has not acknowledged yet, so any packet that arrives brings the synth fully up to date, and the synth answers
+ * with the client and version it applied. Each page picks a random client id when it loads, so with several pages
+ * open every page can tell its own acknowledgements apart and equal versions from two pages are both applied.
+ * The version is repeated at the end so a packet read while the GUI thread is still writing the next one is
+ * detected and skipped
+ */
+#pragma once
+
+#include "ParameterStore.h"
+
+class GuiProtocol {
+public:
+	static const int kHeaderSize = 3; // client, version and number of pairs
+	static const int kMaxVersion = 16777216; // versions and client ids stay below this, so they are exact floats
+	static const int kAckSize = 2; // client and version
+	
+	// floats needed to hold a packet that changes every parameter
+	static int packetSize(int numParams) { return kHeaderSize + 2 * numParams + 1; }
+	
+	GuiProtocol() {} // Default constructor
+	
+	// apply a new, complete packet to the store and publish it. Returns false if the buffer holds
+	// nothing new or was caught mid-write, otherwise the packet is acknowledged with getAck()
+	bool decode(const float *packet, int size, ParameterStore& store);
+	
+	// write a packet for count changed parameters, returns the number of floats used (for the host
+	// driver and benchmarks, the synth itself only decodes)
+	static int encode(float *packet, int client, int version, const int *ids, const float *values, int count);
+	
+	int getClient() { return client_; } // client of the last packet applied
+	int getVersion() { return version_; } // and its version
+	void getAck(float *ack) { ack[0] = client_; ack[1] = version_; } // kAckSize floats for the browser
+	
+	~GuiProtocol() {} // Destructor
+
+private:
+	int client_ = 0; // clients and versions start at 1, so an empty buffer is never applied
+	int version_ = 0;
+	int ids_[ParameterStore::kMaxParams];
+	float values_[ParameterStore::kMaxParams];
+};
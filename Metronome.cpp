@@ -0,0 +1,39 @@
+/* Metronome.cpp: implements the fractional-phase sequencer clock
+ */
+#include "Metronome.h"
+#include <cmath>
+
+Metronome::Metronome(float sampleRate) {
+	setup(sampleRate);
+}
+
+void Metronome::setup(float sampleRate) {
+	inverseSampleRate_ = 1.0 / sampleRate;
+	increment_ = inverseSampleRate_; // 1 Hz until a tempo is set
+	phase_ = 0.0;
+}
+
+void Metronome::setTempo(float ticksPerSecond) {
+	increment_ = ticksPerSecond * inverseSampleRate_;
+}
+
+void Metronome::reset() {
+	phase_ = 1.0;
+}
+
+int Metronome::framesUntilTick() {
+	if(phase_ >= 1.0)
+		return 0;
+	// first frame whose phase reaches 1, the remainder is carried over by tick()
+	return (int)ceil((1.0 - phase_) / increment_);
+}
+
+void Metronome::tick() {
+	phase_ -= 1.0;
+	if(phase_ >= 1.0) // tempo jumped up by more than a period, do not queue up ticks
+		phase_ = 0.0;
+}
+
+void Metronome::advance(int numFrames) {
+	phase_ += numFrames * increment_;
+}
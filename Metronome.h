@@ -0,0 +1,27 @@
+/* Metronome.h: base tempo clock for the sequencer, scheduled ahead of time
+ * Keeps a fractional phase so the period is never truncated to whole samples, and reports
+ * how many frames are left before the next tick so a block can be split at exact offsets
+ */
+#pragma once
+
+class Metronome {
+public:
+	Metronome() {} // Default constructor
+	Metronome(float sampleRate);
+	
+	void setup(float sampleRate);
+	
+	void setTempo(float ticksPerSecond); // can change at any frame, applies from the current phase
+	void reset(); // make the next tick due on the current frame
+	
+	int framesUntilTick(); // 0 if a tick is due on the current frame
+	void tick(); // consume the tick due on the current frame
+	void advance(int numFrames); // move forward, must not pass a due tick
+	
+	~Metronome() {} // Destructor
+
+private:
+	double phase_; // progress towards the next tick, a tick is due at 1
+	double increment_; // phase per frame
+	double inverseSampleRate_;
+};
@@ -3,6 +3,8 @@
  */
 
 #include "Oscillator.h"
+#include "PitchQuantizer.h"
+#include <algorithm>
 #include <cmath>
 
 Oscillator::Oscillator(float sampleRate, WaveType type) {
@@ -12,67 +14,27 @@ Oscillator::Oscillator(float sampleRate, WaveType type) {
 void Oscillator::setup(float sampleRate, WaveType type) {
 	waveType_ = type;
 	scale_ = NO_SCALE;
+	quantizer_ = &PitchQuantizer::shared(); // builds the scale tables on first use
 	
-	sawtoothOscillator_.setup(sampleRate, 0.0f);
-	sawtoothSubOsc1_.setup(sampleRate, 0.0f);
-	sawtoothSubOsc2_.setup(sampleRate, 0.0f);
-	
-	squareOscillator_.setup(sampleRate);
-	squareSubOsc1_.setup(sampleRate);
-	squareSubOsc2_.setup(sampleRate);
-	
+	inverseSampleRate_ = 1.0f / sampleRate;
+	phase_ = 0;
+	sub1_.setup();
+	sub2_.setup();
+	antiAlias_ = getDefaultAntiAlias();
+	method_ = antiAlias_;
 	
 	// By default subharmonic oscillators are in unison with the main
 	sub1DivAmnt_ = 1.0f;
 	sub2DivAmnt_ = 1.0f;
+	setCoreFrequencies(kMinVcoFreq, sub1DivAmnt_, sub2DivAmnt_);
+	updateMethod();
+	resetCores(0, 2 * kNumCores);
 }
 
 void Oscillator::setFrequency(float frequency, float sub1Offset, float sub2Offset) {
-	if(scale_ == NO_SCALE) {
-		//do nothing, frequency stays the same
-	}
-	else if(scale_ == CHROMATIC) {
-		//round frequency to nearest semitone
-		int semitones = round(12.0f * log2(frequency / kMinVcoFreq));
-		frequency = kMinVcoFreq * powf(2.0, semitones / 12.0f);
-	}
-	else{
-		//calculate semitones past closest octave to get scale degrees
-		//add 0.5 so next section rounds instead of truncates
-		float semitones = 12.0f * log2(frequency / kMinVcoFreq);
-		int trunc_semitones = (int)semitones;
-		int numOctaves = trunc_semitones / 12;
-		float pastOct = (semitones - trunc_semitones) + (trunc_semitones % 12) + 0.5f;
-		
-		//get information about currently selected scale
-		int scaleLen;
-		int* scaleDegrees;
-		if(scale_ == MAJOR) {
-			scaleLen = kMajorLen;
-			scaleDegrees = (int *)kMajorDegrees;
-		} else if(scale_ == MINOR) {
-			scaleLen = kMinorLen;
-			scaleDegrees = (int *)kMinorDegrees;
-		} else { //PENTATONIC
-			scaleLen = kPentatonicLen;
-			scaleDegrees = (int *)kPentatonicDegrees;
-		}
-		
-		//round to nearest scale degree
-		//this isn't a perfect rounding, it biases down if scale degrees are further than a semitone
-		for(unsigned int i = 0; i < scaleLen; i++) {
-			if(pastOct == scaleDegrees[i]) {
-				break; // already in scale
-			}
-			if(pastOct < scaleDegrees[i]) {
-				pastOct = scaleDegrees[i];
-				break;
-			}
-		}
-		
-		//convert back to Hz
-		semitones = numOctaves * 12 + pastOct;
-		frequency = kMinVcoFreq * powf(2.0, semitones / 12.0f);
+	if(scale_ != NO_SCALE) {
+		//round frequency to the nearest note of the scale, using precomputed tables
+		frequency = quantizer_->quantize(scale_, frequency);
 	}
 	
 	//update subharmonic oscillators so they keep the correct ratio to the base
@@ -80,17 +42,103 @@ void Oscillator::setFrequency(float frequency, float sub1Offset, float sub2Offse
 	float sub2Final = std::max(kMinSubDiv, std::min(kMaxSubDiv, (sub2DivAmnt_ + sub2Offset)));
 	
 	//apply frequency update
-	sawtoothOscillator_.setFrequency(frequency);
-	sawtoothSubOsc1_.setFrequency(frequency / sub1Final);
-	sawtoothSubOsc2_.setFrequency(frequency / sub2Final);
+	setCoreFrequencies(frequency, sub1Final, sub2Final);
+}
+
+void Oscillator::setFrequencyBlock(float *frequencies, int stride, float sub1Offset, float sub2Offset, int numFrames) {
+	if(numFrames <= 0)
+		return;
+	float sub1Final = std::max(kMinSubDiv, std::min(kMaxSubDiv, (sub1DivAmnt_ + sub1Offset)));
+	float sub2Final = std::max(kMinSubDiv, std::min(kMaxSubDiv, (sub2DivAmnt_ + sub2Offset)));
+	if(scale_ != NO_SCALE)
+		frequencyKernel<true>(frequencies, stride, sub1Final, sub2Final, numFrames);
+	else
+		frequencyKernel<false>(frequencies, stride, sub1Final, sub2Final, numFrames);
+	const float *last = frequencies + (numFrames - 1) * stride;
+	setCoreFrequencies(last[0], last[1], last[2]);
+}
+
+template<bool kQuantize>
+void Oscillator::frequencyKernel(float *frequencies, int stride, float sub1Final, float sub2Final, int numFrames) {
+	for(int n = 0; n < numFrames; n++) {
+		float *f = frequencies + n * stride;
+		float frequency = kQuantize ? quantizer_->quantize(scale_, f[0]) : f[0];
+		f[0] = frequency;
+		f[1] = sub1Final;
+		f[2] = sub2Final;
+	}
+}
+
+void Oscillator::setCoreFrequencies(float frequency, float sub1Divisor, float sub2Divisor) {
+	frequency_ = frequency;
+	increment_ = phaseIncrement(frequency, inverseSampleRate_);
+	int divisor1 = sub1_.getDivisor();
+	int divisor2 = sub2_.getDivisor();
+	sub1_.setDivisor((int)sub1Divisor, phase_);
+	sub2_.setDivisor((int)sub2Divisor, phase_);
 	
-	squareOscillator_.setFrequency(frequency);
-	squareSubOsc1_.setFrequency(frequency / sub1Final);
-	squareSubOsc2_.setFrequency(frequency / sub2Final);
+	for(int core = 0; core < 2 * kNumCores; core++)
+		cores_.setIncrement(method_, core, coreIncrement(core));
+	// a new division moves the subharmonic's phase, so its cores restart from there
+	if(sub1_.getDivisor() != divisor1) {
+		resetCores(1, 2);
+		resetCores(kNumCores + 1, kNumCores + 2);
+	}
+	if(sub2_.getDivisor() != divisor2) {
+		resetCores(2, 3);
+		resetCores(kNumCores + 2, kNumCores + 3);
+	}
+}
+
+uint32_t Oscillator::corePhase(int core) {
+	int c = core % kNumCores;
+	uint32_t phase = (c == 0) ? phase_ : ((c == 1) ? sub1_.getPhase(phase_) : sub2_.getPhase(phase_));
+	return (core < kNumCores) ? phase : phase ^ 0x80000000u;
+}
+
+uint32_t Oscillator::coreIncrement(int core) {
+	int c = core % kNumCores;
+	return (c == 0) ? increment_ : ((c == 1) ? sub1_.getIncrement(increment_) : sub2_.getIncrement(increment_));
+}
+
+void Oscillator::resetCores(int first, int last) {
+	for(int core = first; core < last; core++)
+		cores_.reset(method_, core, corePhase(core), coreIncrement(core));
+}
+
+void Oscillator::updateMethod() {
+	WavetableCore *tables = cores_.get<WAVETABLE>();
+	for(int core = 0; core < kNumCores; core++)
+		tables[core].setWave(waveType_);
+	AntiAlias method = (waveType_ == USER_WAVE) ? WAVETABLE : antiAlias_;
+	if(method == method_)
+		return;
+	method_ = method;
+	resetCores(0, 2 * kNumCores);
+}
+
+void Oscillator::advancePhase() {
+	uint32_t next = phase_ + increment_;
+	bool wrapped = next < phase_;
+	phase_ = next;
+	sub1_.advance(wrapped);
+	sub2_.advance(wrapped);
 }
 
 void Oscillator::setWaveType(WaveType type) {
+	WaveType previous = waveType_;
 	waveType_ = type;
+	updateMethod();
+	// the second saws are not advanced while the cores are sawtooths, so restart them
+	if(type == SQUARE && previous != SQUARE)
+		resetCores(kNumCores, 2 * kNumCores);
+}
+
+void Oscillator::setAntiAlias(AntiAlias method) {
+	if(method == antiAlias_)
+		return;
+	antiAlias_ = method;
+	updateMethod();
 }
 
 void Oscillator::setScale(Scale scale) {
@@ -99,26 +147,69 @@ void Oscillator::setScale(Scale scale) {
 
 void Oscillator::setSub1Ratio(int div_amnt) {
 	sub1DivAmnt_ = div_amnt;
-	int currFreq = sawtoothOscillator_.getFrequency();
-	sawtoothSubOsc1_.setFrequency(currFreq / sub1DivAmnt_);
-	squareSubOsc1_.setFrequency(currFreq / sub1DivAmnt_);
+	setCoreFrequencies(frequency_, sub1DivAmnt_, sub2_.getDivisor());
 }
 
 void Oscillator::setSub2Ratio(int div_amnt) {
 	sub2DivAmnt_ = div_amnt;
-	int currFreq = sawtoothOscillator_.getFrequency();
-	sawtoothSubOsc2_.setFrequency(currFreq / sub2DivAmnt_);
-	squareSubOsc2_.setFrequency(currFreq / sub2DivAmnt_);
+	setCoreFrequencies(frequency_, sub1_.getDivisor(), sub2DivAmnt_);
 }
 
 float Oscillator::process(float amplitude, float sub1Amp, float sub2Amp) {
 	float out;
-	//output scaled combined sample of whichever waveform is currently active
-	if(waveType_ == SAW) {
-		out = amplitude * sawtoothOscillator_.process() + sub1Amp * sawtoothSubOsc1_.process() + sub2Amp * sawtoothSubOsc2_.process();
+	renderBlock<false>(&out, &amplitude, &sub1Amp, &sub2Amp, 1);
+	return out;
+}
+
+void Oscillator::processBlock(float *out, int numFrames, float amplitude, float sub1Amp, float sub2Amp) {
+	renderBlock<false>(out, &amplitude, &sub1Amp, &sub2Amp, numFrames);
+}
+
+void Oscillator::processBlock(float *out, const float *amplitude, const float *sub1Amp, const float *sub2Amp, int numFrames) {
+	renderBlock<true>(out, amplitude, sub1Amp, sub2Amp, numFrames);
+}
+
+template<bool kLevelPerSample>
+void Oscillator::renderBlock(float *out, const float *amplitude, const float *sub1Amp, const float *sub2Amp, int numFrames) {
+	//output whichever waveform is currently active, tables hold every wave type so never need a second saw
+	if(waveType_ != SQUARE || method_ == WAVETABLE) {
+		switch(method_) {
+			case DPW2: renderCores<DPW2, false, kLevelPerSample>(out, amplitude, sub1Amp, sub2Amp, numFrames); break;
+			case DPW3: renderCores<DPW3, false, kLevelPerSample>(out, amplitude, sub1Amp, sub2Amp, numFrames); break;
+			case DPW4: renderCores<DPW4, false, kLevelPerSample>(out, amplitude, sub1Amp, sub2Amp, numFrames); break;
+			case POLYBLEP: renderCores<POLYBLEP, false, kLevelPerSample>(out, amplitude, sub1Amp, sub2Amp, numFrames); break;
+			case MINBLEP: renderCores<MINBLEP, false, kLevelPerSample>(out, amplitude, sub1Amp, sub2Amp, numFrames); break;
+			default: renderCores<WAVETABLE, false, kLevelPerSample>(out, amplitude, sub1Amp, sub2Amp, numFrames); break;
+		}
 	}
 	else { //SQUARE
-		out = amplitude * squareOscillator_.process() + sub1Amp * squareSubOsc1_.process() + sub2Amp * squareSubOsc2_.process();
+		switch(method_) {
+			case DPW2: renderCores<DPW2, true, kLevelPerSample>(out, amplitude, sub1Amp, sub2Amp, numFrames); break;
+			case DPW3: renderCores<DPW3, true, kLevelPerSample>(out, amplitude, sub1Amp, sub2Amp, numFrames); break;
+			case DPW4: renderCores<DPW4, true, kLevelPerSample>(out, amplitude, sub1Amp, sub2Amp, numFrames); break;
+			case POLYBLEP: renderCores<POLYBLEP, true, kLevelPerSample>(out, amplitude, sub1Amp, sub2Amp, numFrames); break;
+			default: renderCores<MINBLEP, true, kLevelPerSample>(out, amplitude, sub1Amp, sub2Amp, numFrames); break;
+		}
 	}
-	return out;
-}
\ No newline at end of file
+}
+
+// levels are read per sample, or from the first entry for the whole block. Square is the difference of two
+// saws half a cycle apart (Valimaki 2006), or read from its own table
+template<AntiAlias Method, bool kSquare, bool kLevelPerSample>
+void Oscillator::renderCores(float *out, const float *amplitude, const float *sub1Amp, const float *sub2Amp, int numFrames) {
+	typename AntiAliasPolicy<Method>::type *cores = cores_.get<Method>();
+	for(int n = 0; n < numFrames; n++) {
+		int i = kLevelPerSample ? n : 0;
+		const uint32_t phases[kNumCores] = {phase_, sub1_.getPhase(phase_), sub2_.getPhase(phase_)};
+		const float levels[kNumCores] = {amplitude[i], sub1Amp[i], sub2Amp[i]};
+		float sample = 0.0f;
+		for(int core = 0; core < kNumCores; core++) {
+			float wave = cores[core].process(phases[core]);
+			if(kSquare && !IsTabulated<typename AntiAliasPolicy<Method>::type>::value)
+				wave -= cores[kNumCores + core].process(phases[core] ^ 0x80000000u);
+			sample += levels[core] * wave;
+		}
+		out[n] = sample;
+		advancePhase();
+	}
+}
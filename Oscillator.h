@@ -3,13 +3,13 @@
  */
 #pragma once
 
-#include <vector>
-#include "SawAntiAlias.h"
-#include "SquareAntiAlias.h"
+#include "AntiAlias.h"
+#include "SubharmonicDivider.h"
 
 enum WaveType {
 	SAW = 0,
-	SQUARE = 1
+	SQUARE = 1,
+	USER_WAVE = 2 // single-cycle wave loaded into Wavetables, always rendered from its tables
 };
 
 enum Scale {
@@ -17,7 +17,9 @@ enum Scale {
 	CHROMATIC = 1,
 	MAJOR = 2,
 	MINOR = 3,
-	PENTATONIC = 4
+	PENTATONIC = 4,
+	USER_SCALE = 5, // loaded from a Scala file, see PitchQuantizer
+	kNumScales = 6
 };
 
 // semi-tones above tonic for each scale type
@@ -28,6 +30,8 @@ const int kMinorLen = 7;
 const int kPentatonicDegrees[5] = {0,3,5,6,10};
 const int kPentatonicLen = 5;
 
+class PitchQuantizer;
+
 // oscillator boundaries as specific in Moog manual
 const float kMinVcoFreq = 262.0f;
 const float kMaxVcoFreq = 4186.0f;
@@ -42,8 +46,12 @@ public:
 	void setup(float sampleRate, WaveType type);
 	
 	void setFrequency(float frequency, float sub1Offset, float sub2Offset);
+	// frequencies for a block, in place: frequencies[n * stride] holds the VCO frequency of frame n and is
+	// replaced by the quantized one, followed by the two subharmonic divisors. The cores keep the last frame's
+	void setFrequencyBlock(float *frequencies, int stride, float sub1Offset, float sub2Offset, int numFrames);
 	void setWaveType(WaveType type);
 	void setScale(Scale scale);
+	void setAntiAlias(AntiAlias method); // restarts the new policy's cores at the current phases. USER_WAVE ignores it
 	
 	// subharmonic oscillators set to base_freq / div_amnt Hz
 	void setSub1Ratio(int div_amnt);
@@ -52,23 +60,56 @@ public:
 	float getSub1Ratio() {return sub1DivAmnt_; }
 	float setSub2Ratio() {return sub2DivAmnt_; }
 	
+	WaveType getWaveType() { return waveType_; }
+	AntiAlias getAntiAlias() { return antiAlias_; }
+	float getFrequency() { return frequency_; } // frequency after quantization
+	int getSub1Divisor() { return sub1_.getDivisor(); } // ratio after sequencer offsets
+	int getSub2Divisor() { return sub2_.getDivisor(); }
+	float getSub1Frequency() { return frequency_ / sub1_.getDivisor(); }
+	float getSub2Frequency() { return frequency_ / sub2_.getDivisor(); }
+	
 	float process(float amplitude, float sub1Amp, float sub2Amp); //outout one sample of combined oscillators & update phase
+	void processBlock(float *out, int numFrames, float amplitude, float sub1Amp, float sub2Amp); // block with fixed levels
+	void processBlock(float *out, const float *amplitude, const float *sub1Amp, const float *sub2Amp, int numFrames); // levels set per sample
 
 	~Oscillator() {} // Destructor
 
 private:
 	WaveType waveType_;
 	Scale scale_;
+	const PitchQuantizer *quantizer_ = nullptr; // shared scale tables
 	
-	SawAntiAlias sawtoothOscillator_;
-	SawAntiAlias sawtoothSubOsc1_;
-	SawAntiAlias sawtoothSubOsc2_;
+	// one phase for the VCO, the subharmonics derive theirs from it and stay locked to it
+	float frequency_;
+	float inverseSampleRate_;
+	uint32_t phase_;
+	uint32_t increment_;
+	SubharmonicDivider sub1_;
+	SubharmonicDivider sub2_;
 	
-	SquareAntiAlias squareOscillator_;
-	SquareAntiAlias squareSubOsc1_;
-	SquareAntiAlias squareSubOsc2_;
+	// band-limiting state of each core, they run on the phases above. Cores 0-2 are the VCO and subharmonic
+	// saws, 3-5 the second saws of a square, half a cycle ahead
+	static const int kNumCores = 3;
+	AntiAlias antiAlias_; // selected policy
+	AntiAlias method_; // policy rendering, WAVETABLE for USER_WAVE and antiAlias_ otherwise
+	AntiAliasCores<2 * kNumCores> cores_;
 	
 	//Get subharmonic frequencies by dividing base by these
 	float sub1DivAmnt_;
 	float sub2DivAmnt_;
+	
+	void setCoreFrequencies(float frequency, float sub1Divisor, float sub2Divisor);
+	void advancePhase(); // step the VCO and count its wraps in the dividers
+	uint32_t corePhase(int core);
+	uint32_t coreIncrement(int core);
+	void resetCores(int first, int last); // cores [first, last) of the current policy
+	void updateMethod(); // follow a change of wave type or policy, restarting the cores if the policy changes
+	
+	// block kernels, the scale, policy and wave type are tested once per block to pick one
+	template<bool kQuantize>
+	void frequencyKernel(float *frequencies, int stride, float sub1Final, float sub2Final, int numFrames);
+	template<bool kLevelPerSample>
+	void renderBlock(float *out, const float *amplitude, const float *sub1Amp, const float *sub2Amp, int numFrames);
+	template<AntiAlias Method, bool kSquare, bool kLevelPerSample>
+	void renderCores(float *out, const float *amplitude, const float *sub1Amp, const float *sub2Amp, int numFrames);
 };
\ No newline at end of file
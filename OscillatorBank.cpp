@@ -0,0 +1,256 @@
+/* OscillatorBank.cpp: implements the vectorised oscillator bank
+ */
+#include "OscillatorBank.h"
+#include "OscillatorBankLanes.h"
+
+OscillatorBank::OscillatorBank(float sampleRate) {
+	setup(sampleRate);
+}
+
+void OscillatorBank::setup(float sampleRate) {
+	sampleRate_ = sampleRate;
+	inverseSampleRate_ = 1.0f / sampleRate;
+	setOversampling(1);
+	for(int i = 0; i < kNumLanes; i++) {
+		// same starting state as SawAntiAlias/SquareAntiAlias
+		phase_[i] = 0;
+		increment_[i] = 0;
+		z1_[i] = 1.0f;
+		z12_[i] = 1.0f;
+		gain_[i] = 0.0f;
+		squareMask_[i] = 0.0f;
+		scaling_[i] = 0.0f;
+	}
+	antiAlias_ = getDefaultAntiAlias();
+	method_ = antiAlias_;
+	for(int vco = 0; vco < kNumVcos; vco++) {
+		waveType_[vco] = SAW;
+		vcoPhase_[vco] = 0;
+		vcoIncrement_[vco] = 0;
+		vcoFrequency_[vco] = 0.0f;
+		for(int sub = 0; sub < kCoresPerVco - 1; sub++)
+			dividers_[vco][sub].setup();
+		setFrequencies(vco, kMinVcoFreq, 1, 1);
+		if(method_ != DPW2) {
+			for(int core = 0; core < kCoresPerVco; core++)
+				resetCore(vco, core);
+		}
+	}
+	updateMethod();
+	anySquare_ = false;
+}
+
+void OscillatorBank::setFrequencies(int vco, float frequency, int sub1Divisor, int sub2Divisor) {
+	bool changed = false;
+	if(frequency != vcoFrequency_[vco]) {
+		vcoFrequency_[vco] = frequency;
+		vcoIncrement_[vco] = phaseIncrement(frequency, inverseSampleRate_);
+		changed = true;
+	}
+	int divisors[kCoresPerVco - 1] = {sub1Divisor, sub2Divisor};
+	bool moved[kCoresPerVco - 1] = {false, false};
+	for(int sub = 0; sub < kCoresPerVco - 1; sub++) {
+		SubharmonicDivider& divider = dividers_[vco][sub];
+		if(divisors[sub] == divider.getDivisor())
+			continue;
+		divider.setDivisor(divisors[sub], vcoPhase_[vco]);
+		phase_[lane(vco, sub + 1)] = divider.getPhase(vcoPhase_[vco]);
+		changed = moved[sub] = true;
+	}
+	if(!changed)
+		return; // avoid the division when nothing changed
+	updateLanes(vco);
+	// a new division moves the subharmonic's phase, so its cores restart from there
+	for(int sub = 0; sub < kCoresPerVco - 1; sub++) {
+		if(moved[sub])
+			resetCore(vco, sub + 1);
+	}
+}
+
+void OscillatorBank::updateLanes(int vco) {
+	float scaling = sampleRate_ / (4.0f * vcoFrequency_[vco]);
+	increment_[lane(vco, 0)] = vcoIncrement_[vco];
+	scaling_[lane(vco, 0)] = scaling;
+	for(int sub = 0; sub < kCoresPerVco - 1; sub++) {
+		const SubharmonicDivider& divider = dividers_[vco][sub];
+		increment_[lane(vco, sub + 1)] = divider.getIncrement(vcoIncrement_[vco]);
+		scaling_[lane(vco, sub + 1)] = scaling * divider.getDivisor();
+	}
+	if(method_ != DPW2) {
+		for(int core = 0; core < kCoresPerVco; core++) {
+			int l = lane(vco, core);
+			cores_.setIncrement(method_, vco * kCoresPerVco + core, increment_[l]);
+			cores_.setIncrement(method_, kNumCores + vco * kCoresPerVco + core, increment_[l]);
+		}
+	}
+}
+
+void OscillatorBank::resetCore(int vco, int core) {
+	int l = lane(vco, core);
+	uint32_t prev = phase_[l] - increment_[l];
+	float bphase = bipolarPhase(prev);
+	float bphase2 = bipolarPhase(prev ^ 0x80000000u); // second saw, half a cycle ahead
+	z1_[l] = bphase * bphase;
+	z12_[l] = bphase2 * bphase2;
+	if(method_ != DPW2) {
+		cores_.reset(method_, vco * kCoresPerVco + core, phase_[l], increment_[l]);
+		cores_.reset(method_, kNumCores + vco * kCoresPerVco + core, phase_[l] ^ 0x80000000u, increment_[l]);
+	}
+}
+
+void OscillatorBank::updateMethod() {
+	WavetableCore *tables = cores_.get<WAVETABLE>();
+	bool anyUser = false;
+	for(int vco = 0; vco < kNumVcos; vco++) {
+		for(int core = 0; core < kCoresPerVco; core++)
+			tables[vco * kCoresPerVco + core].setWave(waveType_[vco]);
+		anyUser = anyUser || waveType_[vco] == USER_WAVE;
+	}
+	AntiAlias method = anyUser ? WAVETABLE : antiAlias_;
+	if(method == method_)
+		return;
+	method_ = method;
+	for(int vco = 0; vco < kNumVcos; vco++) {
+		updateLanes(vco);
+		for(int core = 0; core < kCoresPerVco; core++)
+			resetCore(vco, core);
+	}
+}
+
+void OscillatorBank::setAntiAlias(AntiAlias method) {
+	if(method == antiAlias_)
+		return;
+	antiAlias_ = method;
+	updateMethod();
+}
+
+void OscillatorBank::setWaveType(int vco, WaveType type) {
+	if(type != waveType_[vco]) {
+		waveType_[vco] = type;
+		updateMethod();
+	}
+	for(int core = 0; core < kCoresPerVco; core++) {
+		int lane = vco * kLanesPerVco + core;
+		if(type == SQUARE && squareMask_[lane] == 0.0f) {
+			// the second saw is not advanced while a core is a sawtooth
+			resetCore(vco, core);
+		}
+		squareMask_[lane] = (type == SQUARE) ? 1.0f : 0.0f;
+	}
+	anySquare_ = false;
+	for(int lane = 0; lane < kNumLanes; lane++)
+		anySquare_ = anySquare_ || squareMask_[lane] != 0.0f;
+}
+
+void OscillatorBank::setOversampling(int factor) {
+	holdShift_ = (factor >= 4) ? 2 : ((factor >= 2) ? 1 : 0);
+	holdMask_ = (1 << holdShift_) - 1;
+}
+
+void OscillatorBank::setGains(int vco, float amplitude, float sub1Amp, float sub2Amp) {
+	gain_[vco * kLanesPerVco] = amplitude;
+	gain_[vco * kLanesPerVco + 1] = sub1Amp;
+	gain_[vco * kLanesPerVco + 2] = sub2Amp;
+}
+
+void OscillatorBank::setOscillator(int vco, Oscillator *osc) {
+	setWaveType(vco, osc->getWaveType());
+	setFrequencies(vco, osc->getFrequency(), osc->getSub1Divisor(), osc->getSub2Divisor());
+}
+
+// the lanes have already stepped, so only a VCO that wrapped needs its subharmonics re-derived. The divided
+// increments are rounded down, this puts them back on the exact divided phase once per VCO cycle
+void OscillatorBank::countWraps() {
+	for(int vco = 0; vco < kNumVcos; vco++) {
+		uint32_t phase = vcoPhase_[vco];
+		uint32_t next = phase + vcoIncrement_[vco];
+		vcoPhase_[vco] = next;
+		if(next >= phase)
+			continue;
+		for(int sub = 0; sub < kCoresPerVco - 1; sub++) {
+			dividers_[vco][sub].advance(true);
+			phase_[lane(vco, sub + 1)] = dividers_[vco][sub].getPhase(next);
+		}
+	}
+}
+
+void OscillatorBank::process(float *out) {
+	dispatch<false>(out, out + 1, nullptr, nullptr, 1);
+}
+
+void OscillatorBank::processBlock(float *out1, float *out2, int numFrames) {
+	dispatch<false>(out1, out2, nullptr, nullptr, numFrames);
+}
+
+void OscillatorBank::processBlock(float *out1, float *out2, const float *frequencies, const float *gains, int numFrames) {
+	dispatch<true>(out1, out2, frequencies, gains, numFrames);
+}
+
+// pick the kernel for the policy and wave types once per block, tables never need the second saw of a square
+template<bool kModulated>
+void OscillatorBank::dispatch(float *out1, float *out2, const float *frequencies, const float *gains, int numFrames) {
+	if(anySquare_ && method_ != WAVETABLE) {
+		switch(method_) {
+			case DPW2: dpwKernel<true, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+			case DPW3: policyKernel<DPW3, true, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+			case DPW4: policyKernel<DPW4, true, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+			case POLYBLEP: policyKernel<POLYBLEP, true, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+			default: policyKernel<MINBLEP, true, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+		}
+	}
+	else {
+		switch(method_) {
+			case DPW2: dpwKernel<false, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+			case DPW3: policyKernel<DPW3, false, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+			case DPW4: policyKernel<DPW4, false, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+			case POLYBLEP: policyKernel<POLYBLEP, false, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+			case MINBLEP: policyKernel<MINBLEP, false, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+			default: policyKernel<WAVETABLE, false, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+		}
+	}
+}
+
+void OscillatorBank::setFrame(const float *frequencies, const float *gains) {
+	for(int vco = 0; vco < kNumVcos; vco++) {
+		int l = vco * kLanesPerVco;
+		setFrequencies(vco, frequencies[l], (int)frequencies[l + 1], (int)frequencies[l + 2]);
+		setGains(vco, gains[l], gains[l + 1], gains[l + 2]);
+	}
+}
+
+// DPW2 on the backend of the current SIMD level, one lane at a time, the baseline's 4 or AVX2's 8
+template<bool kSquare, bool kModulated>
+void OscillatorBank::dpwKernel(float *out1, float *out2, const float *frequencies, const float *gains, int numFrames) {
+	switch(getSimdLevel()) {
+		case SIMD_SCALAR: processKernel<SimdScalar, kSquare, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+#if SIMD_HAVE_AVX2
+		case SIMD_AVX2: dpwKernelAvx2(kSquare, kModulated, out1, out2, frequencies, gains, numFrames); break;
+#endif
+		default: processKernel<SimdBaseline, kSquare, kModulated>(out1, out2, frequencies, gains, numFrames); break;
+	}
+}
+
+template<AntiAlias Method, bool kSquare, bool kModulated>
+void OscillatorBank::policyKernel(float *out1, float *out2, const float *frequencies, const float *gains, int numFrames) {
+	typename AntiAliasPolicy<Method>::type *cores = cores_.get<Method>();
+	float *out[kNumVcos] = {out1, out2};
+	for(int n = 0; n < numFrames; n++) {
+		if(kModulated && (n & holdMask_) == 0)
+			setFrame(frequencies + (n >> holdShift_) * kNumLanes, gains + (n >> holdShift_) * kNumLanes);
+		for(int vco = 0; vco < kNumVcos; vco++) {
+			float sample = 0.0f;
+			for(int core = 0; core < kCoresPerVco; core++) {
+				int l = lane(vco, core);
+				int c = vco * kCoresPerVco + core;
+				float wave = cores[c].process(phase_[l]);
+				if(kSquare && squareMask_[l] != 0.0f)
+					wave -= cores[kNumCores + c].process(phase_[l] ^ 0x80000000u);
+				sample += gain_[l] * wave;
+			}
+			out[vco][n] = sample;
+		}
+		for(int l = 0; l < kNumLanes; l++)
+			phase_[l] += increment_[l];
+		countWraps();
+	}
+}
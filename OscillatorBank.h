@@ -0,0 +1,96 @@
+/* OscillatorBank.h: structure-of-arrays bank of DPW sawtooth cores for both VCOs and their subharmonics
+ * Each VCO keeps one 32-bit phase and the subharmonics derive theirs from it through a SubharmonicDivider each
+ * time it wraps, stepping by the divided increment in between. The phase steps and the DPW of all cores run
+ * together, 4 or 8 lanes at a time at the Simd.h level (NEON/SSE2 or AVX2, see OscillatorBankLanes.h). The other band-limiting policies of AntiAlias.h run one
+ * core at a time on the same phases, and so do the wavetables whenever a VCO plays USER_WAVE
+ */
+#pragma once
+
+#include "Oscillator.h"
+#include "Simd.h"
+
+class OscillatorBank {
+public:
+	static const int kNumVcos = 2;
+	static const int kCoresPerVco = 3; // VCO, sub 1, sub 2
+	static const int kLanesPerVco = 4; // cores padded to a whole 4-lane vector
+	static const int kNumLanes = kNumVcos * kLanesPerVco;
+
+	OscillatorBank() {} // Default constructor
+	OscillatorBank(float sampleRate);
+
+	void setup(float sampleRate);
+
+	void setFrequencies(int vco, float frequency, int sub1Divisor, int sub2Divisor);
+	void setWaveType(int vco, WaveType type);
+	void setGains(int vco, float amplitude, float sub1Amp, float sub2Amp);
+	void setAntiAlias(AntiAlias method); // restarts every core at its current phase
+	AntiAlias getAntiAlias() { return antiAlias_; }
+	void setOscillator(int vco, Oscillator *osc); // copy frequencies and wave type from an Oscillator
+
+	void process(float *out); // output one sample per VCO into out[kNumVcos] & update phases
+	void processBlock(float *out1, float *out2, int numFrames); // same, for a block with fixed parameters
+	// modulated version, frame n reads kNumLanes frequencies and gains from frequencies/gains + n * kNumLanes,
+	// the lanes of a VCO's subharmonics hold their divisors rather than frequencies. When oversampled, numFrames
+	// counts output samples and each frame is held for the oversampling factor
+	void processBlock(float *out1, float *out2, const float *frequencies, const float *gains, int numFrames);
+	// samples per frame of the modulated processBlock, 1, 2 or 4. Set up the bank at the oversampled rate too
+	void setOversampling(int factor);
+	
+	static int lane(int vco, int core) { return vco * kLanesPerVco + core; } // lane index of a core
+
+	~OscillatorBank() {} // Destructor
+
+private:
+	// advance every core by one sample on backend V, store weighted outputs. Square support is a template
+	// parameter so a block of sawtooths never tests for it, the blocks below choose once
+	template<typename V, bool kSquare>
+	void processLanes(float *laneOut);
+	template<typename V, bool kSquare, bool kModulated>
+	void processKernel(float *out1, float *out2, const float *frequencies, const float *gains, int numFrames);
+	template<bool kSquare, bool kModulated>
+	void dpwKernel(float *out1, float *out2, const float *frequencies, const float *gains, int numFrames);
+#if SIMD_HAVE_AVX2
+	// processKernel<SimdAvx2>, built for AVX2 in OscillatorBankAvx2.cpp
+	void dpwKernelAvx2(bool square, bool modulated, float *out1, float *out2, const float *frequencies, const float *gains, int numFrames);
+#endif
+	// same for a policy other than DPW2, one core at a time
+	template<AntiAlias Method, bool kSquare, bool kModulated>
+	void policyKernel(float *out1, float *out2, const float *frequencies, const float *gains, int numFrames);
+	template<bool kModulated>
+	void dispatch(float *out1, float *out2, const float *frequencies, const float *gains, int numFrames);
+
+	void setFrame(const float *frequencies, const float *gains); // one frame of a modulated block
+	void countWraps(); // re-derive a VCO's subharmonic phases from its dividers whenever it wraps
+	void updateLanes(int vco); // increments and DPW scaling after a frequency or divisor change
+	void resetCore(int vco, int core); // restart a core's differentiators at its current phase
+	void updateMethod(); // follow a change of wave type or policy, restarting every core if the policy changes
+
+	// per VCO phase and the dividers of its subharmonics
+	uint32_t vcoPhase_[kNumVcos];
+	uint32_t vcoIncrement_[kNumVcos];
+	float vcoFrequency_[kNumVcos];
+	SubharmonicDivider dividers_[kNumVcos][kCoresPerVco - 1];
+
+	// one lane per core, VCO n uses lanes [n * kLanesPerVco, n * kLanesPerVco + kCoresPerVco)
+	alignas(32) uint32_t phase_[kNumLanes]; // current phase, 0 on padding lanes
+	alignas(32) uint32_t increment_[kNumLanes]; // phase step, the VCO's divided for a subharmonic
+	alignas(32) float z1_[kNumLanes]; // previous parabolic sample
+	alignas(32) float z12_[kNumLanes]; // same for the second saw, half a cycle ahead, used for square
+	alignas(32) float scaling_[kNumLanes]; // DPW amplitude correction, sample rate / (4 * frequency)
+	alignas(32) float gain_[kNumLanes]; // output level, 0 on padding lanes
+	alignas(32) float squareMask_[kNumLanes]; // 1 where the core outputs square, 0 for saw
+
+	// policy state, core vco * kCoresPerVco + n and the second saw of its square kNumCores after it
+	static const int kNumCores = kNumVcos * kCoresPerVco;
+	AntiAlias antiAlias_; // selected policy
+	AntiAlias method_; // policy rendering: the cores share one, so WAVETABLE for both VCOs if either plays USER_WAVE
+	WaveType waveType_[kNumVcos];
+	AntiAliasCores<2 * kNumCores> cores_;
+
+	float sampleRate_;
+	float inverseSampleRate_;
+	int holdShift_; // log2 of the oversampling factor
+	int holdMask_;
+	bool anySquare_; // skip the second saw when every core is a sawtooth
+};
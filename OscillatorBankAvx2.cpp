@@ -0,0 +1,41 @@
+/* OscillatorBankAvx2.cpp: the DPW lanes of OscillatorBank built for AVX2, both VCOs in one 8-lane vector
+ * Everything included before the target region is built for the baseline as usual. Inside it there are only the
+ * templates of OscillatorBankLanes.h, instantiated for SimdAvx2 alone, so no baseline code is built for AVX2.
+ * OscillatorBank only calls in here when getSimdLevel() is SIMD_AVX2
+ */
+#include "OscillatorBank.h"
+#include "Simd.h"
+
+#if SIMD_HAVE_AVX2
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include "OscillatorBankLanes.h"
+
+void OscillatorBank::dpwKernelAvx2(bool square, bool modulated, float *out1, float *out2, const float *frequencies, const float *gains, int numFrames) {
+	if(square) {
+		if(modulated)
+			processKernel<SimdAvx2, true, true>(out1, out2, frequencies, gains, numFrames);
+		else
+			processKernel<SimdAvx2, true, false>(out1, out2, frequencies, gains, numFrames);
+	}
+	else {
+		if(modulated)
+			processKernel<SimdAvx2, false, true>(out1, out2, frequencies, gains, numFrames);
+		else
+			processKernel<SimdAvx2, false, false>(out1, out2, frequencies, gains, numFrames);
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // SIMD_HAVE_AVX2
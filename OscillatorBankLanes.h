@@ -0,0 +1,46 @@
+/* OscillatorBankLanes.h: the DPW lane kernels of OscillatorBank, templated on the Simd.h backend
+ * Only templates live here, so every build of them is its own instantiation: OscillatorBank.cpp builds the scalar
+ * and baseline ones, OscillatorBankAvx2.cpp the AVX2 one under that target
+ */
+#pragma once
+
+#include "OscillatorBank.h"
+#include "Simd.h"
+
+// one DPW step (Valimaki 2006) on a vector of saw cores, bphase is the [-1,1] ramp
+template<typename V>
+inline V dpwSaw(V bphase, float *z1, V scaling) {
+	V sqr = V::mul(bphase, bphase); //turn sawtooth into parabolic waveform
+	V out = V::mul(V::sub(sqr, V::load(z1)), scaling); //differentiate and rescale
+	V::store(z1, sqr);
+	return out;
+}
+
+template<typename V, bool kSquare>
+void OscillatorBank::processLanes(float *laneOut) {
+	for(int lane = 0; lane < kNumLanes; lane += V::kWidth) {
+		V scaling = V::load(scaling_ + lane);
+		V out = dpwSaw(V::bipolar(phase_ + lane, 0x80000000u), z1_ + lane, scaling);
+		if(kSquare) {
+			//square is the difference of two saws half a cycle apart, masked per core
+			V saw2 = dpwSaw(V::bipolar(phase_ + lane, 0), z12_ + lane, scaling);
+			out = V::sub(out, V::mul(saw2, V::load(squareMask_ + lane)));
+		}
+		V::store(laneOut + lane, V::mul(out, V::load(gain_ + lane)));
+		V::step(phase_ + lane, increment_ + lane);
+	}
+	countWraps();
+}
+
+// frequencies and gains are only read when kModulated, otherwise they stay fixed for the block
+template<typename V, bool kSquare, bool kModulated>
+void OscillatorBank::processKernel(float *out1, float *out2, const float *frequencies, const float *gains, int numFrames) {
+	alignas(32) float laneOut[kNumLanes];
+	for(int n = 0; n < numFrames; n++) {
+		if(kModulated && (n & holdMask_) == 0)
+			setFrame(frequencies + (n >> holdShift_) * kNumLanes, gains + (n >> holdShift_) * kNumLanes);
+		processLanes<V, kSquare>(laneOut);
+		out1[n] = laneOut[0] + laneOut[1] + laneOut[2];
+		out2[n] = laneOut[kLanesPerVco] + laneOut[kLanesPerVco + 1] + laneOut[kLanesPerVco + 2];
+	}
+}
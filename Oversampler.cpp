@@ -0,0 +1,214 @@
+/* Oversampler.cpp: polyphase halfband filters and the 2x/4x converters built from them
+ */
+#include "Oversampler.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// zeroth order modified Bessel function of the first kind, for the Kaiser window
+double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for(int k = 1; k < 50; k++) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+	return sum;
+}
+}
+
+static int gOversampleFactor = OVERSAMPLE_FACTOR;
+static int gOversampleStages = OVERSAMPLE_STAGES;
+
+int getOversampleFactor() {
+	return gOversampleFactor;
+}
+
+int getOversampleStages() {
+	return gOversampleStages;
+}
+
+bool setOversampling(int factor, int stages) {
+	if(factor != 1 && factor != 2 && factor != kMaxOversampling)
+		return false;
+	gOversampleFactor = factor;
+	gOversampleStages = stages;
+	return true;
+}
+
+template<int kTaps>
+void Halfband<kTaps>::setup(double beta) {
+	static_assert(kTaps % 4 == 3, "halfband taps have to be 4k + 3 so the outermost ones are not zero");
+	for(int c = 0; c < kNumCoefficients; c++) {
+		double t = 2 * c + 1; // distance from the centre
+		double sinc = sin(M_PI * t / 2.0) / (M_PI * t / 2.0);
+		double r = t / kCentre;
+		coefficients_[c] = (float)(0.5 * sinc * besselI0(beta * sqrt(1.0 - r * r)) / besselI0(beta));
+	}
+	reset();
+}
+
+template<int kTaps>
+void Halfband<kTaps>::reset() {
+	std::fill(work_, work_ + (kTaps - 1) * kNumLanes, 0.0f);
+}
+
+template<int kTaps>
+void Halfband<kTaps>::decimate(float *out, const float *in, int numFrames) {
+	if(getSimdLevel() == SIMD_SCALAR)
+		decimateLanes<SimdScalar>(out, in, numFrames);
+	else
+		decimateLanes<SimdBaseline>(out, in, numFrames);
+}
+
+template<int kTaps>
+void Halfband<kTaps>::interpolate(float *out, const float *in, int numFrames) {
+	if(getSimdLevel() == SIMD_SCALAR)
+		interpolateLanes<SimdScalar>(out, in, numFrames);
+	else
+		interpolateLanes<SimdBaseline>(out, in, numFrames);
+}
+
+// Output m is centred on input 2m + kCentre of the work buffer, which is odd, so the centre tap reads one phase
+// of the input and the side taps, in symmetric pairs, the other
+template<int kTaps>
+template<typename V>
+void Halfband<kTaps>::decimateLanes(float *out, const float *in, int numFrames) {
+	const int history = kTaps - 1;
+	const V half = V::splat(0.5f);
+	V taps[kNumCoefficients];
+	for(int c = 0; c < kNumCoefficients; c++)
+		taps[c] = V::splat(coefficients_[c]);
+	while(numFrames > 0) {
+		int frames = std::min(numFrames, (int)kChunkFrames); // copied, so the constant needs no definition
+		memcpy(work_ + history * kNumLanes, in, 2 * frames * kNumLanes * sizeof(float));
+		for(int m = 0; m < frames; m++) {
+			for(int lane = 0; lane < kNumLanes; lane += V::kWidth) {
+				const float *centre = work_ + (2 * m + kCentre) * kNumLanes + lane;
+				V sum = V::mul(half, V::load(centre));
+				for(int c = 0; c < kNumCoefficients; c++) {
+					int offset = (2 * c + 1) * kNumLanes;
+					sum = V::add(sum, V::mul(taps[c], V::add(V::load(centre - offset), V::load(centre + offset))));
+				}
+				V::store(out + m * kNumLanes + lane, sum);
+			}
+		}
+		memmove(work_, work_ + 2 * frames * kNumLanes, history * kNumLanes * sizeof(float));
+		in += 2 * frames * kNumLanes;
+		out += frames * kNumLanes;
+		numFrames -= frames;
+	}
+}
+
+// The input stuffed with zeros and filtered with twice the taps: even outputs only meet the side taps and odd
+// outputs only the centre one, a delayed input sample
+template<int kTaps>
+template<typename V>
+void Halfband<kTaps>::interpolateLanes(float *out, const float *in, int numFrames) {
+	const int history = kCentre;
+	V taps[kNumCoefficients];
+	for(int c = 0; c < kNumCoefficients; c++)
+		taps[c] = V::splat(2.0f * coefficients_[c]);
+	while(numFrames > 0) {
+		int frames = std::min(numFrames, 2 * kChunkFrames);
+		memcpy(work_ + history * kNumLanes, in, frames * kNumLanes * sizeof(float));
+		for(int i = 0; i < frames; i++) {
+			for(int lane = 0; lane < kNumLanes; lane += V::kWidth) {
+				const float *w = work_ + i * kNumLanes + lane;
+				V sum = V::splat(0.0f);
+				for(int c = 0; c < kNumCoefficients; c++) {
+					sum = V::add(sum, V::mul(taps[c], V::add(V::load(w + ((kCentre + 2 * c + 1) / 2) * kNumLanes),
+						V::load(w + ((kCentre - 2 * c - 1) / 2) * kNumLanes))));
+				}
+				V::store(out + 2 * i * kNumLanes + lane, sum);
+				V::store(out + (2 * i + 1) * kNumLanes + lane, V::load(w + ((kCentre + 1) / 2) * kNumLanes));
+			}
+		}
+		memmove(work_, work_ + frames * kNumLanes, history * kNumLanes * sizeof(float));
+		in += frames * kNumLanes;
+		out += 2 * frames * kNumLanes;
+		numFrames -= frames;
+	}
+}
+
+template<int kTaps>
+double Halfband<kTaps>::stopbandDb(double edge) const {
+	double worst = 0.0;
+	for(int i = 0; i <= 1000; i++) {
+		double f = edge + (0.5 - edge) * i / 1000.0;
+		double gain = 0.5;
+		for(int c = 0; c < kNumCoefficients; c++)
+			gain += 2.0 * coefficients_[c] * cos(2.0 * M_PI * f * (2 * c + 1));
+		worst = std::max(worst, fabs(gain));
+	}
+	return 20.0 * log10(std::max(worst, 1e-30));
+}
+
+template class Halfband<55>;
+template class Halfband<23>;
+
+// Kaiser betas for about 75 dB (inner) and 70 dB (outer) over the bands stopbandDb() checks
+void Oversampler::setup(int factor) {
+	factor_ = factor;
+	inner_.setup(7.5);
+	outer_.setup(7.0);
+}
+
+void Oversampler::reset() {
+	inner_.reset();
+	outer_.reset();
+}
+
+void Oversampler::upsample(float *out, const float *in, int numFrames) {
+	const int lanes = Halfband<55>::kNumLanes;
+	if(factor_ == 1) {
+		memcpy(out, in, numFrames * lanes * sizeof(float));
+		return;
+	}
+	if(factor_ == 2) {
+		inner_.interpolate(out, in, numFrames);
+		return;
+	}
+	while(numFrames > 0) {
+		int frames = std::min(numFrames, (int)kChunkFrames);
+		inner_.interpolate(scratch_, in, frames);
+		outer_.interpolate(out, scratch_, 2 * frames);
+		in += frames * lanes;
+		out += 4 * frames * lanes;
+		numFrames -= frames;
+	}
+}
+
+void Oversampler::downsample(float *out, const float *in, int numFrames) {
+	const int lanes = Halfband<55>::kNumLanes;
+	if(factor_ == 1) {
+		if(out != in)
+			memmove(out, in, numFrames * lanes * sizeof(float));
+		return;
+	}
+	if(factor_ == 2) {
+		inner_.decimate(out, in, numFrames);
+		return;
+	}
+	while(numFrames > 0) {
+		int frames = std::min(numFrames, (int)kChunkFrames);
+		outer_.decimate(scratch_, in, 2 * frames);
+		inner_.decimate(out, scratch_, frames);
+		in += 4 * frames * lanes;
+		out += frames * lanes;
+		numFrames -= frames;
+	}
+}
+
+// 18 kHz passband at 44.1 kHz. The inner octave has to stop whatever would fold below it, the outer one whatever
+// would fold into the inner octave's passband and transition
+double Oversampler::stopbandDb() const {
+	const double passband = 18000.0 / 44100.0 / 2.0; // cycles per sample at 2x
+	const double innerEdge = 0.5 - passband;
+	const double outerEdge = 0.5 - innerEdge / 2.0;
+	if(factor_ == 1)
+		return 0.0;
+	double db = inner_.stopbandDb(innerEdge);
+	return factor_ == 2 ? db : std::max(db, outer_.stopbandDb(outerEdge));
+}
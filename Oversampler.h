@@ -0,0 +1,82 @@
+/* Oversampler.h: 2x and 4x rate conversion for running the oscillators and filters oversampled
+ * Each octave is a halfband FIR, whose every other tap is zero, run in polyphase form so only the nonzero taps
+ * are computed at the lower rate. Signals are four interleaved lanes, the voices of a ResFilterBank, and every
+ * tap runs on all four at once on the Simd.h baseline backend. render.cpp picks the factor and which stages run oversampled in setup()
+ */
+#pragma once
+
+enum OversampleStage {
+	OVERSAMPLE_OSCILLATORS = 1,
+	OVERSAMPLE_FILTER = 2
+};
+
+#ifndef OVERSAMPLE_FACTOR
+#define OVERSAMPLE_FACTOR 1
+#endif
+#ifndef OVERSAMPLE_STAGES
+#define OVERSAMPLE_STAGES (OVERSAMPLE_OSCILLATORS | OVERSAMPLE_FILTER)
+#endif
+
+const int kMaxOversampling = 4;
+
+// factor (1, 2 or 4) and OversampleStage flags used by setup(), OVERSAMPLE_FACTOR and OVERSAMPLE_STAGES until set
+int getOversampleFactor();
+int getOversampleStages();
+bool setOversampling(int factor, int stages); // false for an unsupported factor
+
+// One halfband octave of kTaps (4k + 3) taps on four interleaved lanes. The taps are a Kaiser windowed sinc,
+// with the cutoff at a quarter of the higher rate
+template<int kTaps>
+class Halfband {
+public:
+	static const int kNumLanes = 4;
+	static const int kCentre = (kTaps - 1) / 2; // odd, so the nonzero side taps are all an even distance apart
+	static const int kNumCoefficients = (kTaps + 1) / 4; // nonzero taps each side of the centre
+
+	void setup(double beta);
+	void reset(); // clear the history
+
+	// numFrames frames from 2 * numFrames. out may equal in
+	void decimate(float *out, const float *in, int numFrames);
+	// 2 * numFrames frames from numFrames, out must not overlap in
+	void interpolate(float *out, const float *in, int numFrames);
+
+	double stopbandDb(double edge) const; // worst gain from edge to Nyquist, in cycles per sample of the higher rate
+
+private:
+	static const int kChunkFrames = 64; // lower rate frames per pass through the work buffer
+
+	// the same on a Simd.h backend, V::kWidth lanes at a time
+	template<typename V>
+	void decimateLanes(float *out, const float *in, int numFrames);
+	template<typename V>
+	void interpolateLanes(float *out, const float *in, int numFrames);
+
+	float coefficients_[kNumCoefficients]; // tap kCentre + 2c + 1, the same as kCentre - 2c - 1
+	// history followed by the input being processed, a frame is kNumLanes floats
+	alignas(16) float work_[(kTaps - 1 + 2 * kChunkFrames) * kNumLanes];
+};
+
+// 1x, 2x or 4x conversion between the audio rate and an oversampled rate. The octave next to the audio rate is
+// the long one, it has to cut off between 20 kHz and the first alias, the octave above it has plenty of room
+class Oversampler {
+public:
+	void setup(int factor);
+	void reset(); // clear the history of both octaves
+	int getFactor() { return factor_; }
+
+	// numFrames audio rate frames to numFrames * factor, out must not overlap in
+	void upsample(float *out, const float *in, int numFrames);
+	// numFrames * factor frames to numFrames at the audio rate. out may equal in
+	void downsample(float *out, const float *in, int numFrames);
+
+	double stopbandDb() const; // worst rejection of the images and aliases that land below 18 kHz at 44.1 kHz
+
+private:
+	static const int kChunkFrames = 64; // audio rate frames per pass through the 2x scratch buffer
+
+	int factor_ = 1;
+	Halfband<55> inner_; // audio rate and 2x
+	Halfband<23> outer_; // 2x and 4x
+	alignas(16) float scratch_[2 * kChunkFrames * Halfband<55>::kNumLanes];
+};
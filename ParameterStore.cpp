@@ -0,0 +1,65 @@
+/* ParameterStore.cpp: implements the triple-buffered parameter handoff
+ */
+#include "ParameterStore.h"
+#include <cmath>
+#include <cstring>
+
+void ParameterStore::setup(const ParameterInfo *info, int numParams) {
+	if(numParams > kMaxParams)
+		numParams = kMaxParams;
+	numParams_ = numParams;
+	for(int i = 0; i < numParams_; i++) {
+		info_[i] = info[i];
+		pending_[i] = values_[i] = info[i].defaultValue;
+	}
+	for(int slot = 0; slot < 3; slot++) {
+		memcpy(slots_[slot], pending_, sizeof(pending_));
+	}
+	back_ = 0;
+	middle_.store(1);
+	front_ = 2;
+	dirty_ = 0;
+	pendingDirty_ = numParams_ == 64 ? ~(uint64_t)0 : (((uint64_t)1 << numParams_) - 1);
+}
+
+void ParameterStore::set(int id, float value) {
+	if(id < 0 || id >= numParams_ || std::isnan(value))
+		return;
+	const ParameterInfo& info = info_[id];
+	if(info.type == PARAM_INT)
+		value = roundf(value);
+	if(value < info.min)
+		value = info.min;
+	else if(value > info.max)
+		value = info.max;
+	pending_[id] = value;
+}
+
+void ParameterStore::publish() {
+	memcpy(slots_[back_], pending_, numParams_ * sizeof(float));
+	// release so the snapshot contents are visible before the consumer can pick up the slot
+	back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & ~kFresh;
+}
+
+bool ParameterStore::consume() {
+	dirty_ = pendingDirty_;
+	pendingDirty_ = 0;
+	if(middle_.load(std::memory_order_relaxed) & kFresh) {
+		front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~kFresh;
+		// compare against the applied values rather than trusting the producer, so snapshots
+		// that were overwritten before the audio thread saw them cannot lose a change
+		const float *snapshot = slots_[front_];
+		for(int i = 0; i < numParams_; i++) {
+			if(snapshot[i] != values_[i]) {
+				values_[i] = snapshot[i];
+				dirty_ |= (uint64_t)1 << i;
+			}
+		}
+	}
+	return dirty_ != 0;
+}
+
+bool ParameterStore::isDirty(int first, int count) const {
+	uint64_t mask = (count >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << count) - 1)) << first;
+	return (dirty_ & mask) != 0;
+}
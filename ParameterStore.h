@@ -0,0 +1,66 @@
+/* ParameterStore.h: GUI parameters handed from the GUI thread to the audio thread without locks
+ * The GUI side fills a full snapshot and publishes it, the audio side takes the newest snapshot at the start
+ * of a block and sees which parameters changed, so values never tear and unchanged ones are not re-applied
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+enum ParameterType {
+	PARAM_FLOAT = 0,
+	PARAM_INT = 1 // rounded to the nearest integer, used for menus and ratios
+};
+
+struct ParameterInfo {
+	ParameterType type;
+	float min;
+	float max;
+	float defaultValue;
+};
+
+class ParameterStore {
+public:
+	static const int kMaxParams = 64; // one dirty bit each
+	
+	ParameterStore() {} // Default constructor
+	
+	void setup(const ParameterInfo *info, int numParams); // every parameter starts at its default and dirty
+	
+	// GUI thread: stage values, then publish them together as one snapshot
+	void set(int id, float value); // clamped to the parameter range, rounded for PARAM_INT
+	void publish();
+	
+	// audio thread: take the newest published snapshot, returns true if any parameter changed
+	bool consume();
+	bool isDirty(int id) const { return (dirty_ >> id) & 1; }
+	bool isDirty(int first, int count) const; // true if any of count parameters from first changed
+	
+	float getFloat(int id) const { return values_[id]; }
+	int getInt(int id) const { return (int)values_[id]; }
+	const float* getValues() const { return values_; } // current values, indexed by parameter id
+	
+	int getNumParams() const { return numParams_; }
+	
+	~ParameterStore() {} // Destructor
+
+private:
+	// three snapshots so neither side ever waits: the producer writes one, the consumer reads one, and the
+	// newest published one waits in the middle. kFresh marks a middle snapshot the consumer has not taken
+	static const int kFresh = 4;
+	float slots_[3][kMaxParams];
+	std::atomic<int> middle_;
+	
+	// GUI thread state
+	int back_;
+	float pending_[kMaxParams];
+	
+	// audio thread state
+	int front_;
+	float values_[kMaxParams];
+	uint64_t dirty_;
+	uint64_t pendingDirty_; // set by setup so the first block applies every parameter
+	
+	ParameterInfo info_[kMaxParams];
+	int numParams_ = 0;
+};
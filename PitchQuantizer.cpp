@@ -0,0 +1,171 @@
+/* PitchQuantizer.cpp: implements the table based pitch quantizer
+ */
+#include "PitchQuantizer.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace {
+const float kTableMinFreq = 16.0f; // lower edge of the bucket table, a power of two
+const float kTableMaxFreq = kTableMinFreq * (1 << PitchQuantizer::kNumOctaves);
+
+inline unsigned int floatBits(float x) {
+	unsigned int bits;
+	memcpy(&bits, &x, sizeof(bits));
+	return bits;
+}
+
+inline float bitsFloat(unsigned int bits) {
+	float x;
+	memcpy(&x, &bits, sizeof(x));
+	return x;
+}
+
+// for positive floats, exponent and top mantissa bits increase monotonically with the value
+const int kBucketShift = 23 - PitchQuantizer::kBucketBits;
+const unsigned int kFirstBucketKey = floatBits(kTableMinFreq) >> kBucketShift;
+}
+
+PitchQuantizer& PitchQuantizer::shared() {
+	static PitchQuantizer quantizer;
+	return quantizer;
+}
+
+PitchQuantizer::PitchQuantizer() {
+	for(int s = 0; s < kNumScales; s++)
+		tables_[s].valid = false;
+
+	float chromatic[12];
+	for(int i = 0; i < 12; i++)
+		chromatic[i] = 100.0f * i;
+	float degrees[12];
+	setScale(CHROMATIC, chromatic, 12);
+	for(int i = 0; i < kMajorLen; i++)
+		degrees[i] = 100.0f * kMajorDegrees[i];
+	setScale(MAJOR, degrees, kMajorLen);
+	for(int i = 0; i < kMinorLen; i++)
+		degrees[i] = 100.0f * kMinorDegrees[i];
+	setScale(MINOR, degrees, kMinorLen);
+	for(int i = 0; i < kPentatonicLen; i++)
+		degrees[i] = 100.0f * kPentatonicDegrees[i];
+	setScale(PENTATONIC, degrees, kPentatonicLen);
+	// the user slot is chromatic until a scale is loaded into it
+	setScale(USER_SCALE, chromatic, 12);
+}
+
+// Expand the degrees over every period that touches the table range, plus one note past each end so the
+// nearest note is always found. Writes the notes if notes is not null, returns how many there are or -1 if
+// they would not fit in kMaxNotes
+static int expandScale(const float *cents, int numDegrees, float periodCents, float *notes) {
+	int firstPeriod = (int)floorf(1200.0f * log2f(kTableMinFreq / kMinVcoFreq) / periodCents) - 1;
+	int numNotes = 0;
+	float last = 0.0f;
+	for(int period = firstPeriod; ; period++) {
+		for(int d = 0; d < numDegrees; d++) {
+			float note = kMinVcoFreq * powf(2.0f, (period * periodCents + cents[d]) / 1200.0f);
+			if(numNotes > 0 && note <= last)
+				continue; // degrees must ascend within the period
+			if(numNotes >= PitchQuantizer::kMaxNotes)
+				return -1;
+			if(notes)
+				notes[numNotes] = note;
+			numNotes++;
+			last = note;
+			if(note > kTableMaxFreq)
+				return numNotes;
+		}
+	}
+}
+
+bool PitchQuantizer::setScale(Scale scale, const float *cents, int numDegrees, float periodCents) {
+	if(scale <= NO_SCALE || scale >= kNumScales || numDegrees < 1 || numDegrees > kMaxDegrees || periodCents <= 0.0f)
+		return false;
+	// count first, so a scale that does not fit leaves the slot's current table as it was
+	if(expandScale(cents, numDegrees, periodCents, nullptr) < 0)
+		return false;
+	ScaleTable& table = tables_[scale];
+	int numNotes = expandScale(cents, numDegrees, periodCents, table.notes);
+	for(int i = 0; i < numNotes - 1; i++)
+		table.thresholds[i] = sqrtf(table.notes[i] * table.notes[i + 1]);
+	table.thresholds[numNotes - 1] = INFINITY;
+	table.numNotes = numNotes;
+
+	// nearest note at the lower edge of every bucket
+	int note = 0;
+	for(int b = 0; b < kNumBuckets; b++) {
+		float edge = bitsFloat((kFirstBucketKey + b) << kBucketShift);
+		while(edge >= table.thresholds[note])
+			note++;
+		table.buckets[b] = note;
+	}
+	table.valid = true;
+	return true;
+}
+
+// Scala format: '!' comment lines, a description, the number of pitches, then one pitch per line
+// as cents (containing a '.') or a ratio. The last pitch is the period, 1/1 is implied.
+bool PitchQuantizer::loadScala(Scale scale, const std::string& path) {
+	std::ifstream file(path);
+	if(!file)
+		return false;
+	std::string line;
+	int field = 0;
+	int count = 0;
+	float cents[kMaxDegrees + 1];
+	int numPitches = 0;
+	cents[numPitches++] = 0.0f;
+	while(std::getline(file, line)) {
+		if(!line.empty() && line[0] == '!')
+			continue;
+		if(field == 0) { // description
+			field++;
+			continue;
+		}
+		if(field == 1) {
+			count = atoi(line.c_str());
+			if(count < 1 || count > kMaxDegrees)
+				return false;
+			field++;
+			continue;
+		}
+		const char *text = line.c_str();
+		while(*text == ' ' || *text == '\t')
+			text++;
+		float value;
+		if(strchr(text, '.') != nullptr) {
+			value = atof(text);
+		}
+		else {
+			int numerator = 0, denominator = 1;
+			if(sscanf(text, "%d/%d", &numerator, &denominator) < 1 || numerator <= 0 || denominator <= 0)
+				return false;
+			value = 1200.0f * log2f((float)numerator / denominator);
+		}
+		cents[numPitches++] = value;
+		if(numPitches == count + 1)
+			break;
+	}
+	if(numPitches != count + 1)
+		return false;
+	// the last pitch is the period, not a degree
+	return setScale(scale, cents, count, cents[count]);
+}
+
+float PitchQuantizer::quantize(Scale scale, float frequency) const {
+	if(scale <= NO_SCALE || scale >= kNumScales || !tables_[scale].valid)
+		return frequency;
+	const ScaleTable& table = tables_[scale];
+
+	if(!(frequency >= kTableMinFreq)) // also catches NaN
+		frequency = kTableMinFreq;
+	else if(frequency >= kTableMaxFreq)
+		frequency = kTableMaxFreq * 0.99999f;
+
+	// buckets are narrower than the steps of any usual scale, so this rarely steps more than once
+	int note = table.buckets[(floatBits(frequency) >> kBucketShift) - kFirstBucketKey];
+	while(frequency >= table.thresholds[note])
+		note++;
+	return table.notes[note];
+}
@@ -0,0 +1,42 @@
+/* PitchQuantizer.h: table based pitch quantization for the oscillators
+ * Every scale is expanded at startup into the sorted list of its note frequencies across the
+ * oscillator range. A frequency is mapped to its note through a bucket table indexed by the
+ * exponent and top mantissa bits of the float, so the audio thread never calls log2 or powf.
+ * Scales are given in cents within a period, so microtonal and non-octave scales work too.
+ */
+#pragma once
+
+#include <string>
+#include "Oscillator.h"
+
+class PitchQuantizer {
+public:
+	static const int kMaxDegrees = 128; // scale degrees per period
+	static const int kMaxNotes = 2048; // notes across the whole table range
+	static const int kBucketBits = 8; // mantissa bits per bucket, 256 buckets per octave (< 7 cents wide)
+	static const int kNumOctaves = 10; // table range, 16 Hz to 16 kHz
+	static const int kNumBuckets = kNumOctaves << kBucketBits;
+
+	// quantizer shared by all oscillators, built with the preset scales on first use
+	static PitchQuantizer& shared();
+
+	// Define the notes of a scale as cents above kMinVcoFreq, repeating every periodCents.
+	// Rebuilds the tables for that scale, call from setup() and never while render() is running.
+	bool setScale(Scale scale, const float *cents, int numDegrees, float periodCents = 1200.0f);
+	bool loadScala(Scale scale, const std::string& path); // load a Scala .scl file into a scale slot
+
+	float quantize(Scale scale, float frequency) const; // nearest note of the scale, in log frequency
+
+private:
+	PitchQuantizer(); // builds the preset scales
+
+	struct ScaleTable {
+		bool valid;
+		int numNotes;
+		float notes[kMaxNotes]; // ascending note frequencies
+		float thresholds[kMaxNotes]; // geometric midpoint to the next note, last one is infinite
+		unsigned short buckets[kNumBuckets]; // nearest note at the lower edge of each bucket
+	};
+
+	ScaleTable tables_[kNumScales];
+};
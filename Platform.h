@@ -0,0 +1,12 @@
+/* Platform.h: selects the Bela API or the host stand-ins used for offline rendering
+ * Build with -DHOST_BUILD to run setup()/render() on a Linux host (see host/HostRender.cpp)
+ */
+#pragma once
+
+#ifdef HOST_BUILD
+#include "host/HostPlatform.h"
+#else
+#include <Bela.h>
+#include <libraries/Gui/Gui.h>
+#include <libraries/Scope/Scope.h>
+#endif
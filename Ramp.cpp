@@ -14,23 +14,32 @@ C++ Real-Time Audio Programming with Bela - Lecture 14: ADSR
 
 #include <cmath>
 #include "Ramp.h"
+#include "FastMath.h"
 
 // Constructor
 Ramp::Ramp() 
 {
 	currentValue_ = 0;
+	targetValue_ = 0;
 	increment_ = 0;
 	counter_ = 0;
 	sampleRate_ = 1;
+	curved_ = false;
+	asymptote_ = distance_ = 0;
+	coefficient_ = 1;
 }
 	
 // Constructor specifying a sample rate
 Ramp::Ramp(float sampleRate) 
 {
 	currentValue_ = 0;
+	targetValue_ = 0;
 	increment_ = 0;
 	counter_ = 0;
 	sampleRate_ = sampleRate;
+	curved_ = false;
+	asymptote_ = distance_ = 0;
+	coefficient_ = 1;
 }
 	
 // Set the sample rate, used for all calculations
@@ -42,7 +51,7 @@ void Ramp::setSampleRate(float rate)
 // Jump to a value
 void Ramp::setValue(float value)
 {
-	currentValue_ = value;
+	currentValue_ = targetValue_ = value;
 	increment_ = 0;
 	counter_ = 0;
 }
@@ -54,19 +63,80 @@ void Ramp::rampTo(float value, float time)
 	// in the specified amount of time
 	increment_ = (value - currentValue_) / (sampleRate_ * time);
 	counter_ = (int)(sampleRate_ * time);
+	targetValue_ = value;
+	curved_ = false;
+	if(counter_ == 0) // too short to ramp, jump straight there
+		currentValue_ = value;
+}
+
+// Curve to a value over a period of time
+void Ramp::curveTo(float value, float time, float overshoot)
+{
+	counter_ = (int)(sampleRate_ * time);
+	targetValue_ = value;
+	if(counter_ == 0) { // too short to ramp, jump straight there
+		currentValue_ = value;
+		curved_ = false;
+		return;
+	}
+	// the distance to the asymptote goes from (1 + overshoot) to overshoot times the segment's length
+	// in counter_ samples, the coefficient is the counter_-th root of their ratio
+	float length = value - currentValue_;
+	asymptote_ = value + overshoot * length;
+	distance_ = currentValue_ - asymptote_;
+	coefficient_ = fastExp2(fastLog2(overshoot / (1.0f + overshoot)) / (float)counter_);
+	curved_ = true;
 }
 	
 // Generate and return the next ramp output
 float Ramp::process()
 {
 	if(counter_ > 0) {
-		counter_--;
-		currentValue_ += increment_;
+		// land exactly on the target so a ramp to zero ends in true silence
+		if(--counter_ == 0)
+			currentValue_ = targetValue_;
+		else if(curved_) {
+			distance_ *= coefficient_;
+			currentValue_ = asymptote_ + distance_;
+		}
+		else
+			currentValue_ += increment_;
 	}
 	
 	return currentValue_;
 }
 	
+// Fill a block with ramp outputs
+void Ramp::processBlock(float *out, int numFrames)
+{
+	// moving part of the ramp, then hold the final value
+	int ramping = counter_ < numFrames ? counter_ : numFrames;
+	float value = currentValue_;
+	if(curved_) {
+		float distance = distance_;
+		for(int n = 0; n < ramping; n++) {
+			distance *= coefficient_;
+			out[n] = asymptote_ + distance;
+		}
+		distance_ = distance;
+		if(ramping > 0)
+			value = out[ramping - 1];
+	}
+	else {
+		for(int n = 0; n < ramping; n++) {
+			value += increment_;
+			out[n] = value;
+		}
+	}
+	counter_ -= ramping;
+	if(ramping > 0 && counter_ == 0) // land exactly on the target, as in process()
+		out[ramping - 1] = value = targetValue_;
+	for(int n = ramping; n < numFrames; n++) {
+		out[n] = value;
+	}
+	currentValue_ = value;
+}
+	
 // Return whether the ramp is finished
 bool Ramp::finished()
 {
@@ -32,12 +32,26 @@ public:
 	// Ramp to a value over a period of time
 	void rampTo(float value, float time);
 	
+	// Curve to a value over a period of time, exponentially like an RC circuit charging towards a point
+	// overshoot times the distance beyond the value, so it arrives on time. The smaller the overshoot the
+	// more curved the segment, each sample costs one multiply and one add
+	void curveTo(float value, float time, float overshoot);
+	
 	// Generate and return the next ramp output
 	float process();
 	
+	// Fill a block with ramp outputs, same as calling process() numFrames times
+	void processBlock(float *out, int numFrames);
+	
 	// Return whether the ramp is finished
 	bool finished();
 	
+	// Return how many more samples the ramp will move for
+	int remaining() { return counter_; }
+	
+	// Return the current output without advancing
+	float getValue() { return currentValue_; }
+	
 	// Destructor
 	~Ramp();
 
@@ -45,6 +59,13 @@ private:
 	// State variables, not accessible to the outside world
 	float sampleRate_;
 	float currentValue_;
+	float targetValue_;
 	float increment_;
 	int   counter_;
+	
+	// curveTo() segments: the distance to the asymptote shrinks by coefficient_ each sample
+	bool  curved_;
+	float asymptote_;
+	float distance_;
+	float coefficient_;
 };
\ No newline at end of file
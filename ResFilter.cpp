@@ -1,39 +1,86 @@
 /***** ResFilter.cpp *****/
 
 #include "ResFilter.h"
-#include <libraries/math_neon/math_neon.h>
+#include "FastMath.h"
 #include <cmath>
 
-ResFilter::ResFilter(float sampleRate, int filterOrder) {
-	setup(sampleRate, filterOrder);
+template<int Order>
+ResFilter<Order>::ResFilter(float sampleRate) {
+	setup(sampleRate);
 } 
 
-void ResFilter::setup(float sampleRate, int filterOrder) {
-	filterOrder_ = filterOrder;
-	filters_.resize(filterOrder_);
+template<int Order>
+void ResFilter<Order>::setup(float sampleRate) {
+	sampleRate_ = sampleRate;
+	table_ = &FilterCoefficientTable::shared(); // builds the table on first use
+	tableSampleRate_ = (int)sampleRate;
+	inverseSampleRate_ = 1.0f / tableSampleRate_;
 	
-	// Initialise each section of the 4th order filter
-	for(unsigned int n = 0; n < filterOrder_; n++) {
+	// Initialise each section of the ladder
+	for(unsigned int n = 0; n < Order; n++) {
 		filters_[n].calculate_coefficients(sampleRate, 1000, 0.75);
 	}
 }
 
-void ResFilter::updateSections(int sampleRate, float cutoff, float resonance) {
-	// Calculate latest filter coefficients
-	for(unsigned int n = 0; n < filterOrder_; n++) {
-		filters_[n].calculate_coefficients(sampleRate, cutoff, resonance);
+template<int Order>
+void ResFilter<Order>::updateSections(int sampleRate, float cutoff, float resonance) {
+	if(sampleRate != tableSampleRate_) {
+		tableSampleRate_ = sampleRate;
+		inverseSampleRate_ = 1.0f / sampleRate;
+	}
+	
+	// Look up the latest filter coefficients once, every section uses the same ones
+	float g, resonanceScale;
+	table_->lookup(cutoff * inverseSampleRate_, g, resonanceScale);
+	float b0 = g * 1.0f / 1.3f;
+	float b1 = g * 0.3f / 1.3f;
+	float a1 = -(1.0f - g);
+	float gRes = resonance * resonanceScale;
+	for(unsigned int n = 0; n < Order; n++) {
+		filters_[n].setCoefficients(b0, b1, a1, gRes);
 	}
 }
 
-float ResFilter::process(float in) {
+template<int Order>
+float ResFilter<Order>::process(float in) {
 	// apply the resonant filter to the input signal
-	float Y1 = filters_[filterOrder_ - 1].getY1(); // get previous final output stored in last filter in bank
+	float Y1 = filters_[Order - 1].getY1(); // get previous final output stored in last filter in bank
 	float Gres = filters_[0].getGRes(); // get the resonance parameter from one of the filters
 	float out = (1.0f + 4.0f * Gres * gComp_) * in - 4.0f * Gres * Y1; //calculate the feedback portion
-	out = tanhf_neon(out); // nonlinearity
-	for(unsigned int n = 0; n < filterOrder_; n++) { //cascading filters to create 4th order low pass
+	out = fastTanh(out); // nonlinearity
+	for(unsigned int n = 0; n < Order; n++) { //cascading filters to create 4th order low pass
 		out = filters_[n].process(out); //output of previous FOFilter is input to the next one
 	}
 	
 	return out;
-}
\ No newline at end of file
+}
+
+template<int Order>
+void ResFilter<Order>::processBlock(float *out, const float *in, int numFrames) {
+	// the feedback path needs the previous output, so the sections run sample by sample
+	for(int n = 0; n < numFrames; n++) {
+		out[n] = process(in[n]);
+	}
+	flushState();
+}
+
+template<int Order>
+void ResFilter<Order>::processBlock(float *out, const float *in, const float *cutoff, const float *resonance, int numFrames) {
+	for(int n = 0; n < numFrames; n++) {
+		updateSections(sampleRate_, cutoff[n], resonance[n]);
+		out[n] = process(in[n]);
+	}
+	flushState();
+}
+
+template<int Order>
+void ResFilter<Order>::flushState() {
+	for(int i = 0; i < Order; i++) {
+		filters_[i].flushState(kFlushThreshold_);
+	}
+}
+
+template class ResFilter<1>;
+template class ResFilter<2>;
+template class ResFilter<3>;
+template class ResFilter<4>;
@@ -1,30 +1,51 @@
 /* ResFilter.h: class for 4ith order low pass Moog filter
  * Adapted from Assignment 1 code
+ * The number of first order sections is a template parameter, so the ladder loops have a fixed trip count
+ * and unroll. ResFilter.cpp instantiates orders 1 to 4
  * Sara Adkins
  */
 #pragma once
 
-#include <vector>
 #include "FOFilter.h"
+#include "FilterCoefficientTable.h"
 
+template<int Order = 4>
 class ResFilter {
 public:
+	static_assert(Order >= 1, "a ladder needs at least one section");
+	static const int kOrder = Order;
+	
 	ResFilter() {}	// Default constructor
-	ResFilter(float sampleRate, int filterOrder); 						
+	ResFilter(float sampleRate); 						
 	
-	void setup(float sampleRate, int filterOrder);
+	void setup(float sampleRate);
 	
 	void updateSections(int sampleRate, float cutoff, float resonance); //update coefficients to reflect new cutoff/resonance
 	
 	float process(float amplitude); //output next sample of filter output, update state
+	void processBlock(float *out, const float *in, int numFrames); //filter a block with the current coefficients, out may equal in
+	void processBlock(float *out, const float *in, const float *cutoff, const float *resonance, int numFrames); //coefficients updated every sample
 
 	~ResFilter() {}	// Destructor
 
 private:
-	// array for storing cascading filters
-	int filterOrder_;
-	std::vector<FOFilter> filters_;
+	float sampleRate_;
+	
+	// coefficients shared by all sections, looked up once per update
+	const FilterCoefficientTable *table_;
+	int tableSampleRate_; // sample rate inverseSampleRate_ was computed for
+	float inverseSampleRate_;
+	FOFilter filters_[Order]; // cascading filters
 	
 	// fixed filter feedback parameter
 	const float gComp_ = 0.5f;
-};
\ No newline at end of file
+	
+	// section state below this is flushed to zero after each block (about -300dB)
+	const float kFlushThreshold_ = 1e-15f;
+	void flushState();
+};
+
+extern template class ResFilter<1>;
+extern template class ResFilter<2>;
+extern template class ResFilter<3>;
+extern template class ResFilter<4>;
@@ -0,0 +1,176 @@
+/* ResFilterBank.cpp: implements the lane-parallel ladder filters
+ */
+#include "ResFilterBank.h"
+#include "FastMath.h"
+#include "Simd.h"
+#include <cmath>
+#include <strings.h>
+
+static const char* const kFilterModelNames[kNumFilterModels] = {"ladder", "zdf"};
+static FilterModel gDefaultFilterModel = FILTER_MODEL;
+
+const char* filterModelName(FilterModel model) {
+	return (model >= 0 && model < kNumFilterModels) ? kFilterModelNames[model] : "unknown";
+}
+
+bool parseFilterModel(const char *name, FilterModel *model) {
+	for(int i = 0; i < kNumFilterModels; i++) {
+		if(strcasecmp(name, kFilterModelNames[i]) == 0) {
+			*model = (FilterModel)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+FilterModel getDefaultFilterModel() {
+	return gDefaultFilterModel;
+}
+
+void setDefaultFilterModel(FilterModel model) {
+	gDefaultFilterModel = model;
+}
+
+ResFilterBank::ResFilterBank(float sampleRate) {
+	setup(sampleRate);
+}
+
+void ResFilterBank::setup(float sampleRate) {
+	table_ = &FilterCoefficientTable::shared(); // builds the table on first use
+	inverseSampleRate_ = 1.0f / (int)sampleRate; // same rounding as ResFilter
+	model_ = getDefaultFilterModel();
+	clearState();
+}
+
+void ResFilterBank::setModel(FilterModel model) {
+	if(model == model_)
+		return;
+	model_ = model;
+	clearState();
+}
+
+void ResFilterBank::processBlock(float *out, const float *in, const float *cutoff, const float *resonance, int numFrames) {
+	bool scalar = getSimdLevel() == SIMD_SCALAR;
+	if(model_ == FILTER_ZDF) {
+		if(scalar)
+			zdfLanes<SimdScalar>(out, in, cutoff, resonance, numFrames);
+		else
+			zdfLanes<SimdBaseline>(out, in, cutoff, resonance, numFrames);
+	}
+	else {
+		if(scalar)
+			ladderLanes<SimdScalar>(out, in, cutoff, resonance, numFrames);
+		else
+			ladderLanes<SimdBaseline>(out, in, cutoff, resonance, numFrames);
+	}
+	flushState();
+}
+
+void ResFilterBank::reset() {
+	clearState();
+}
+
+// V::kWidth lanes at a time, all four for a 4-lane backend
+template<typename V>
+void ResFilterBank::ladderLanes(float *out, const float *in, const float *cutoff, const float *resonance, int numFrames) {
+	const V one = V::splat(1.0f);
+	const V four = V::splat(4.0f);
+	const V comp = V::splat(gComp_);
+	const V b0Scale = V::splat(1.0f);
+	const V b1Scale = V::splat(0.3f);
+	const V norm = V::splat(1.3f);
+	float g[V::kWidth];
+	float resonanceScale[V::kWidth];
+	
+	for(int lane = 0; lane < kNumLanes; lane += V::kWidth) {
+		for(int n = 0; n < numFrames; n++) {
+			// table lookups are scalar, everything after them runs on all lanes
+			const float *c = cutoff + n * kNumLanes + lane;
+			for(int l = 0; l < V::kWidth; l++) {
+				table_->lookup(c[l] * inverseSampleRate_, g[l], resonanceScale[l]);
+			}
+			V gain = V::load(g);
+			V b0 = V::div(V::mul(gain, b0Scale), norm);
+			V b1 = V::div(V::mul(gain, b1Scale), norm);
+			V a1 = V::sub(V::splat(0.0f), V::sub(one, gain));
+			V gRes = V::mul(V::splat(resonance[n]), V::load(resonanceScale));
+			
+			// feedback from the last section and the tanh nonlinearity, as in ResFilter::process
+			V x = V::load(in + n * kNumLanes + lane);
+			V fourGRes = V::mul(four, gRes);
+			x = V::sub(V::mul(V::add(one, V::mul(fourGRes, comp)), x), V::mul(fourGRes, V::load(y1_ + (kNumSections - 1) * kNumLanes + lane)));
+			x = fastTanh(x);
+			
+			for(int s = 0; s < kNumSections; s++) {
+				float *x1 = x1_ + s * kNumLanes + lane;
+				float *y1 = y1_ + s * kNumLanes + lane;
+				V y = V::sub(V::add(V::mul(b0, x), V::mul(b1, V::load(x1))), V::mul(a1, V::load(y1)));
+				V::store(x1, x);
+				V::store(y1, y);
+				x = y;
+			}
+			V::store(out + n * kNumLanes + lane, x);
+		}
+	}
+}
+
+// Each TPT one-pole outputs y = G x + (1 - G) s for its input x and integrator state s, so the last section is
+// G^4 u + S, with S what the states contribute. The tanh is the only nonlinearity in the loop: solving the
+// feedback u = tanh(x - k y4) linearly gives the estimate that one evaluation of tanh then corrects
+template<typename V>
+void ResFilterBank::zdfLanes(float *out, const float *in, const float *cutoff, const float *resonance, int numFrames) {
+	const V one = V::splat(1.0f);
+	const V four = V::splat(4.0f);
+	const V comp = V::splat(gComp_);
+	float gains[V::kWidth];
+	
+	for(int lane = 0; lane < kNumLanes; lane += V::kWidth) {
+		for(int n = 0; n < numFrames; n++) {
+			const float *c = cutoff + n * kNumLanes + lane;
+			for(int l = 0; l < V::kWidth; l++) {
+				gains[l] = table_->prewarpedGain(c[l] * inverseSampleRate_);
+			}
+			V g = V::load(gains);
+			V k = V::mul(four, V::splat(resonance[n]));
+			V x = V::mul(V::add(one, V::mul(k, comp)), V::load(in + n * kNumLanes + lane));
+			
+			// y4 = G^4 u + S, solved for u = x - k y4
+			V state = V::splat(0.0f);
+			V gN = one;
+			for(int s = 0; s < kNumSections; s++) {
+				state = V::add(V::mul(state, g), V::load(s_ + s * kNumLanes + lane));
+				gN = V::mul(gN, g);
+			}
+			state = V::mul(state, V::sub(one, g));
+			V estimate = V::div(V::add(V::mul(gN, x), state), V::add(one, V::mul(k, gN)));
+			V u = fastTanh(V::sub(x, V::mul(k, estimate)));
+			
+			for(int s = 0; s < kNumSections; s++) {
+				float *si = s_ + s * kNumLanes + lane;
+				V v = V::mul(V::sub(u, V::load(si)), g);
+				u = V::add(v, V::load(si));
+				V::store(si, V::add(u, v));
+			}
+			V::store(out + n * kNumLanes + lane, u);
+		}
+	}
+}
+
+void ResFilterBank::clearState() {
+	for(int i = 0; i < kNumSections * kNumLanes; i++) {
+		x1_[i] = 0.0f;
+		y1_[i] = 0.0f;
+		s_[i] = 0.0f;
+	}
+}
+
+void ResFilterBank::flushState() {
+	for(int i = 0; i < kNumSections * kNumLanes; i++) {
+		if(fabsf(x1_[i]) < kFlushThreshold_)
+			x1_[i] = 0.0f;
+		if(fabsf(y1_[i]) < kFlushThreshold_)
+			y1_[i] = 0.0f;
+		if(fabsf(s_[i]) < kFlushThreshold_)
+			s_[i] = 0.0f;
+	}
+}
@@ -0,0 +1,69 @@
+/* ResFilterBank.h: four 4th order Moog ladder filters run side by side, one voice per vector lane
+ * Same per-sample structure as ResFilter, but the sections of all lanes are advanced together, on the Simd.h
+ * baseline backend or one lane at a time at SIMD_SCALAR. The FILTER_ZDF model replaces the sections and their
+ * one-sample feedback delay with a zero-delay-feedback ladder, which tracks a modulated cutoff up to Nyquist
+ * without the polynomial corrections or oversampling
+ */
+#pragma once
+
+#include "FilterCoefficientTable.h"
+
+enum FilterModel {
+	FILTER_LADDER = 0, // ResFilter's sections, feedback from the previous sample and polynomial corrections
+	FILTER_ZDF = 1, // TPT one-poles with a tan prewarped cutoff, feedback solved within the sample (Zavalishin 2012)
+	kNumFilterModels = 2
+};
+
+#ifndef FILTER_MODEL
+#define FILTER_MODEL FILTER_LADDER
+#endif
+
+const char* filterModelName(FilterModel model);
+bool parseFilterModel(const char *name, FilterModel *model); // accepts "ladder" and "zdf", any case
+
+// model used by banks set up after this is set, FILTER_MODEL until changed
+FilterModel getDefaultFilterModel();
+void setDefaultFilterModel(FilterModel model);
+
+class ResFilterBank {
+public:
+	static const int kNumLanes = 4; // voices per bank
+	static const int kNumSections = 4; // first order sections per ladder
+	
+	ResFilterBank() {} // Default constructor
+	ResFilterBank(float sampleRate);
+	
+	void setup(float sampleRate);
+	void setModel(FilterModel model); // clears the state when the model changes
+	FilterModel getModel() { return model_; }
+	
+	// in, out and cutoff are interleaved, frame n of lane l is at n * kNumLanes + l. The resonance
+	// knob is shared by every lane, one value per frame. out may equal in
+	void processBlock(float *out, const float *in, const float *cutoff, const float *resonance, int numFrames);
+	
+	void reset(); // clear the state, for input that resumes after the bank has been skipped
+	
+	~ResFilterBank() {} // Destructor
+
+private:
+	// each model on Simd.h backend V, V::kWidth lanes at a time
+	template<typename V>
+	void ladderLanes(float *out, const float *in, const float *cutoff, const float *resonance, int numFrames);
+	template<typename V>
+	void zdfLanes(float *out, const float *in, const float *cutoff, const float *resonance, int numFrames);
+	void clearState();
+	void flushState();
+	
+	const FilterCoefficientTable *table_;
+	float inverseSampleRate_;
+	FilterModel model_;
+	
+	// section state, section s of lane l is at s * kNumLanes + l
+	alignas(16) float x1_[kNumSections * kNumLanes];
+	alignas(16) float y1_[kNumSections * kNumLanes];
+	alignas(16) float s_[kNumSections * kNumLanes]; // integrator state of the FILTER_ZDF sections
+	
+	// same feedback and flush constants as ResFilter
+	const float gComp_ = 0.5f;
+	const float kFlushThreshold_ = 1e-15f;
+};
@@ -3,6 +3,7 @@
  */
 #include <cmath>
 #include "SawAntiAlias.h"
+#include "SubharmonicDivider.h"
 
 SawAntiAlias::SawAntiAlias(float sampleRate, float phaseOffset) {
 	setup(sampleRate, phaseOffset);
@@ -18,13 +19,15 @@ void SawAntiAlias::setup(float sampleRate, float phaseOffset)
 	scalingFactor_ = sampleRate / 4.0f;
 	
 	// Initialise the starting state
-	phase_ = phaseOffset;
+	phase_ = (uint32_t)(phaseOffset * kPhaseCycle);
+	increment_ = 0;
 	z1_ = 1.0f;
 }
 
 // Set the oscillator frequency
 void SawAntiAlias::setFrequency(float f) {
 	frequency_ = f;
+	increment_ = phaseIncrement(f, inverseSampleRate_);
 }
 
 // Get the oscillator frequency
@@ -37,17 +40,47 @@ float SawAntiAlias::process() {
 	float out = 0;
 	
 	//Algorithm from Valimaki 2006
-	float bphase = phase_ * 2.0f - 1.0f; //convert [0,1] ramp to [-1,1]
+	float bphase = bipolarPhase(phase_); //convert phase to [-1,1] ramp
 	float sqr_bphase = bphase * bphase; //turn sawtooth into parabolic waveform
 	out = (sqr_bphase  - z1_); //differentiate
 	z1_ = sqr_bphase; //save state for next differentiation
 	out = out * scalingFactor_ / frequency_; //recover original amplitude by scaling by f0
 	
-	// update and wrap phase
-	phase_ = phase_ + (inverseSampleRate_ * frequency_);
-	while(phase_ > 1.0f) {
-		phase_ -= 1.0f;
-	}
+	// update phase, it wraps by overflow
+	phase_ += increment_;
 	
 	return out;
-}	
\ No newline at end of file
+}
+
+// Same as calling process() numFrames times, with the state kept in registers
+void SawAntiAlias::processBlock(float *out, int numFrames) {
+	uint32_t phase = phase_;
+	float z1 = z1_;
+	float scaling = scalingFactor_ / frequency_;
+	for(int n = 0; n < numFrames; n++) {
+		float bphase = bipolarPhase(phase);
+		float sqr_bphase = bphase * bphase;
+		out[n] = (sqr_bphase - z1) * scaling;
+		z1 = sqr_bphase;
+		phase += increment_;
+	}
+	phase_ = phase;
+	z1_ = z1;
+}
+
+// Frequency modulated version, frequency[n] applies to sample n
+void SawAntiAlias::processBlock(float *out, const float *frequency, int numFrames) {
+	uint32_t phase = phase_;
+	float z1 = z1_;
+	for(int n = 0; n < numFrames; n++) {
+		float bphase = bipolarPhase(phase);
+		float sqr_bphase = bphase * bphase;
+		out[n] = (sqr_bphase - z1) * scalingFactor_ / frequency[n];
+		z1 = sqr_bphase;
+		phase += phaseIncrement(frequency[n], inverseSampleRate_);
+	}
+	phase_ = phase;
+	z1_ = z1;
+	if(numFrames > 0)
+		setFrequency(frequency[numFrames - 1]);
+}
@@ -3,7 +3,7 @@
  */
 #pragma once
 
-#include <vector>
+#include <cstdint>
 
 class SawAntiAlias {
 public:
@@ -16,14 +16,17 @@ public:
 	float getFrequency(); // Get the oscillator frequency
 	
 	float process(); // Get the next sample and update the phase
+	void processBlock(float *out, int numFrames); // Fill a block at the current frequency
+	void processBlock(float *out, const float *frequency, int numFrames); // Fill a block, frequency set per sample
 	
 	~SawAntiAlias() {} // Destructor
 
 private:
-	float phase_; // current phase
+	uint32_t phase_; // current phase, a cycle is 2^32 so it wraps on overflow
+	uint32_t increment_; // phase step per sample
 	float z1_; // store previous sample
 
 	float inverseSampleRate_; // 1 divided by the audio sample rate	
 	float scalingFactor_; //f0-based scaling
 	float frequency_; // Frequency of the oscillator
-};
\ No newline at end of file
+};
@@ -3,30 +3,61 @@
  */
 #include "Sequence.h"
 #include "Oscillator.h"
+#include "FastMath.h"
+#include <algorithm>
 #include <cmath>
 
 void Sequence::setup() {
 	currRange_ = ranges_[0];
+	mode_ = VCO;
 	metroBeat_ = 0;
-	beatOffsets_.resize(kNumBeats_);
 	for(unsigned int i = 0; i < kNumBeats_; i++) {
 		beatOffsets_[i] = 0.0f;
+		updateStep(i);
 	}
 	isActive_ = false;
 }
 
 void Sequence::setRange(int rangeIdx) {
+	if(ranges_[rangeIdx] == currRange_)
+		return;
 	currRange_ = ranges_[rangeIdx];
+	for(unsigned int i = 0; i < kNumBeats_; i++) {
+		updateStep(i);
+	}
+}
+
+void Sequence::setMode(SeqMode mode) {
+	if(mode == mode_)
+		return;
+	mode_ = mode;
+	for(unsigned int i = 0; i < kNumBeats_; i++) {
+		updateStep(i);
+	}
 }
 
 //set offset of current beat, normalized [-1,1]
 void Sequence::setBeatOffset(int beatIdx, float value) {
+	if(value == beatOffsets_[beatIdx])
+		return; // the GUI delta packets can repeat a value, e.g. when one is re-sent before its ack arrives
 	beatOffsets_[beatIdx] = value;
+	updateStep(beatIdx);
+}
+
+//cache the modulation for one beat, only called when a knob, range or mode changes
+void Sequence::updateStep(int beatIdx) {
+	octaveRatios_[beatIdx] = fastExp2(currRange_ * beatOffsets_[beatIdx]);
+	int octOffset = fastRoundToInt(currRange_ * beatOffsets_[beatIdx]);
+	
+	Step& step = steps_[beatIdx];
+	step.ratio = (mode_ == VCO) ? octaveRatios_[beatIdx] : 1.0f;
+	step.sub1Offset = (mode_ == SUB1) ? octOffset : 0;
+	step.sub2Offset = (mode_ == SUB2) ? octOffset : 0;
 }
 
 //how many octaves to offset base frequency on current beat
 float Sequence::getCurrOffset() {
-	return powf(2.0, currRange_ * beatOffsets_[metroBeat_]);
+	return octaveRatios_[metroBeat_];
 }
 
 void Sequence::setIsActive(bool isActive) {
@@ -37,21 +68,32 @@ bool Sequence::getIsActive() {
 	return isActive_;
 }
 
-void Sequence::modulateOscillator(float oscFrequency, SeqMode mode, Oscillator *osc) {
-	//determine which waveform of oscillator to modulate
-	if(mode == VCO) {
-		oscFrequency = oscFrequency * getCurrOffset(); //get modulated frequency
-		oscFrequency = std::max(std::min(kMaxOscFreq, oscFrequency), kMinOscFreq); //clip to valid range
-		osc->setFrequency(oscFrequency, 0, 0); //set vco frequency with no change to subharmonic ratio
-	}
-	else if(mode == SUB1) {
-		int octOffset = round(currRange_ * beatOffsets_[metroBeat_]);
-		osc->setFrequency(oscFrequency, octOffset, 0); // modulate ratio of subharmonic 1
-	}
-	else { //SUB2
-		int octOffset = round(currRange_ * beatOffsets_[metroBeat_]);
-		osc->setFrequency(oscFrequency, 0, octOffset); // modulate ratio of subharmonic 2
+void Sequence::modulateOscillator(float oscFrequency, Oscillator *osc) {
+	//the cached step only modulates the waveform selected by the mode
+	const Step& step = steps_[metroBeat_];
+	oscFrequency = oscFrequency * step.ratio; //get modulated frequency
+	oscFrequency = std::max(std::min(kMaxOscFreq, oscFrequency), kMinOscFreq); //clip to valid range
+	osc->setFrequency(oscFrequency, step.sub1Offset, step.sub2Offset);
+}
+
+void Sequence::modulateBlock(const float *oscFrequencies, Oscillator *osc, float *frequencies, int stride, int numFrames) {
+	//the mode only changes between blocks, so it picks a kernel once instead of being tested every sample
+	if(mode_ == VCO)
+		modulateKernel<VCO>(oscFrequencies, osc, frequencies, stride, numFrames);
+	else if(mode_ == SUB1)
+		modulateKernel<SUB1>(oscFrequencies, osc, frequencies, stride, numFrames);
+	else
+		modulateKernel<SUB2>(oscFrequencies, osc, frequencies, stride, numFrames);
+}
+
+template<SeqMode Mode>
+void Sequence::modulateKernel(const float *oscFrequencies, Oscillator *osc, float *frequencies, int stride, int numFrames) {
+	const Step& step = steps_[metroBeat_];
+	for(int n = 0; n < numFrames; n++) {
+		float oscFrequency = (Mode == VCO) ? oscFrequencies[n] * step.ratio : oscFrequencies[n];
+		frequencies[n * stride] = std::max(std::min(kMaxOscFreq, oscFrequency), kMinOscFreq);
 	}
+	osc->setFrequencyBlock(frequencies, stride, (Mode == SUB1) ? step.sub1Offset : 0.0f, (Mode == SUB2) ? step.sub2Offset : 0.0f, numFrames);
 }
 
 void Sequence::beat() {
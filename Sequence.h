@@ -3,7 +3,6 @@
  */
 #pragma once
 
-#include <vector>
 #include "Oscillator.h"
 
 //Sequence can modulate one waveform of the oscillator
@@ -24,12 +23,16 @@ public:
 	void setup();
 
 	void setRange(int rangeIdx); // set octave range for sequence knobs
+	void setMode(SeqMode mode); // set which waveform of the oscillator the sequence modulates
 	
 	void setBeatOffset(int beatIdx, float value); // set frequency offset at specified beat index
 	float getCurrOffset(); // get current beat in sequence
 	bool getIsActive(); // check if a rhythm is triggering this sequence
 	void setIsActive(bool isActive); // indicate a rhythm is triggering this sequence
-	void modulateOscillator(float oscFrequency, SeqMode mode, Oscillator *osc); // update oscillator frequency based on current beat settings
+	void modulateOscillator(float oscFrequency, Oscillator *osc); // update oscillator frequency based on current beat settings
+	// same for a block of knob frequencies, writing each frame's VCO and subharmonic frequencies to
+	// frequencies + n * stride (see Oscillator::setFrequencyBlock). The beat must not change within the block
+	void modulateBlock(const float *oscFrequencies, Oscillator *osc, float *frequencies, int stride, int numFrames);
 	
 	void beat(); // increment beat position, wraps around
 	void reset(); // reset to 1st beat
@@ -37,12 +40,26 @@ public:
 	~Sequence() {} // Destructor
 
 private:
-	const int kNumBeats_ = 4; // number of beats in sequence
-	const std::vector<int> ranges_ = {1,2,5}; //frequency offset ranges, in +/- octaves
+	static const int kNumBeats_ = 4; // number of beats in sequence
+	const int ranges_[3] = {1,2,5}; //frequency offset ranges, in +/- octaves
+	
+	// modulation applied on one beat, so the audio loop does not depend on the mode
+	struct Step {
+		float ratio; // multiplier for the VCO frequency, 1 unless mode is VCO
+		float sub1Offset; // added to the subharmonic 1 divisor, 0 unless mode is SUB1
+		float sub2Offset; // added to the subharmonic 2 divisor, 0 unless mode is SUB2
+	};
+	
+	void updateStep(int beatIdx); // recompute the cached modulation of one beat
+	template<SeqMode Mode>
+	void modulateKernel(const float *oscFrequencies, Oscillator *osc, float *frequencies, int stride, int numFrames); // mode fixed per block
 	
 	int currRange_; //current frequency range
+	SeqMode mode_; //waveform being modulated
 	int metroBeat_; //current beat
-	std::vector<float> beatOffsets_; //keep track of frequency offsets at each beat position
+	float beatOffsets_[kNumBeats_]; //keep track of frequency offsets at each beat position
+	float octaveRatios_[kNumBeats_]; //2^(range * offset) for each beat
+	Step steps_[kNumBeats_]; //cached modulation for each beat
 	
 	bool isActive_;
 
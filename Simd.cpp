@@ -0,0 +1,60 @@
+/* Simd.cpp: names of the SIMD levels and the CPU check behind the runtime dispatch
+ */
+#include "Simd.h"
+#include <strings.h>
+
+static const char* const kSimdLevelNames[kNumSimdLevels] = {"scalar", "neon", "sse2", "avx2"};
+
+// the best level the CPU supports, found once
+static SimdLevel detectSimdLevel() {
+#if SIMD_HAVE_AVX2
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return SIMD_AVX2;
+#endif
+#if defined(__SSE2__)
+	return SIMD_SSE2;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	return SIMD_NEON;
+#else
+	return SIMD_SCALAR;
+#endif
+}
+
+static SimdLevel gBestSimdLevel = detectSimdLevel();
+static SimdLevel gSimdLevel = gBestSimdLevel;
+
+const char* simdLevelName(SimdLevel level) {
+	return (level >= 0 && level < kNumSimdLevels) ? kSimdLevelNames[level] : "unknown";
+}
+
+bool parseSimdLevel(const char *name, SimdLevel *level) {
+	for(int i = 0; i < kNumSimdLevels; i++) {
+		if(strcasecmp(name, kSimdLevelNames[i]) == 0) {
+			*level = (SimdLevel)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool simdLevelSupported(SimdLevel level) {
+	switch(level) {
+		case SIMD_SCALAR: return true;
+		case SIMD_NEON: return gBestSimdLevel == SIMD_NEON;
+		case SIMD_SSE2: return gBestSimdLevel >= SIMD_SSE2;
+		case SIMD_AVX2: return gBestSimdLevel == SIMD_AVX2;
+		default: return false;
+	}
+}
+
+SimdLevel getSimdLevel() {
+	return gSimdLevel;
+}
+
+bool setSimdLevel(SimdLevel level) {
+	if(!simdLevelSupported(level))
+		return false;
+	gSimdLevel = level;
+	return true;
+}
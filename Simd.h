@@ -0,0 +1,236 @@
+/* Simd.h: vector types for the lane-parallel DSP and the level their kernels run at
+ * Each backend wraps one register, or a single float for the scalar fallback, behind the same static operations, so
+ * a kernel templated on the backend builds for any of them. Every operation but NEON's div is exact or correctly
+ * rounded, so the scalar, SSE2 and AVX2 backends compute bit-identical lanes as long as the build does not contract
+ * multiplies and adds into FMA. NEON's div is a refined reciprocal estimate and may differ in the last bit. SSE2 and NEON
+ * are the baseline of the targets that have them. AVX2 is built only into the kernels that fill its 8 lanes (see
+ * OscillatorBankAvx2.cpp) and chosen at runtime when the CPU has it. FastMath.h approximates on the same types
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+// AVX2 kernels are compiled for that target function by function, so any x86 build can carry them
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && defined(__GNUC__)
+#include <immintrin.h>
+#define SIMD_HAVE_AVX2 1
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_HAVE_AVX2 0
+#endif
+
+enum SimdLevel {
+	SIMD_SCALAR = 0, // one lane at a time, every target
+	SIMD_NEON = 1, // 4 lanes, Bela
+	SIMD_SSE2 = 2, // 4 lanes, every x86-64
+	SIMD_AVX2 = 3, // 8 lanes where a kernel has them, 4 otherwise
+	kNumSimdLevels = 4
+};
+
+const char* simdLevelName(SimdLevel level);
+bool parseSimdLevel(const char *name, SimdLevel *level); // accepts the names above, any case
+bool simdLevelSupported(SimdLevel level); // built into this binary and available on this CPU
+
+// level the kernels dispatch on each block, the best supported one until set
+SimdLevel getSimdLevel();
+bool setSimdLevel(SimdLevel level); // false if not supported
+
+// Every backend has kWidth lanes in v and these operations, lane by lane. Loads and stores need no alignment.
+// round(a) is the nearest integer with halves away from zero, from the truncation and its exact remainder, for
+// |a| < 2^31. pow2i(n) is 2^n for an integral n in [-126, 127], split(x, e) returns the mantissa of a positive normal x in
+// [1, 2) with its exponent in e, bipolar() and step() work on 32-bit phases (see SubharmonicDivider.h)
+struct SimdScalar {
+	static const int kWidth = 1;
+	typedef bool mask_t;
+	float v;
+
+	static SimdScalar load(const float *p) { return {*p}; }
+	static void store(float *p, SimdScalar a) { *p = a.v; }
+	static SimdScalar splat(float x) { return {x}; }
+	static SimdScalar add(SimdScalar a, SimdScalar b) { return {a.v + b.v}; }
+	static SimdScalar sub(SimdScalar a, SimdScalar b) { return {a.v - b.v}; }
+	static SimdScalar mul(SimdScalar a, SimdScalar b) { return {a.v * b.v}; }
+	static SimdScalar div(SimdScalar a, SimdScalar b) { return {a.v / b.v}; }
+	static SimdScalar min(SimdScalar a, SimdScalar b) { return {a.v < b.v ? a.v : b.v}; }
+	static SimdScalar max(SimdScalar a, SimdScalar b) { return {a.v > b.v ? a.v : b.v}; }
+	static SimdScalar abs(SimdScalar a) { return {a.v < 0.0f ? -a.v : a.v}; }
+	static mask_t less(SimdScalar a, SimdScalar b) { return a.v < b.v; }
+	static SimdScalar select(mask_t m, SimdScalar a, SimdScalar b) { return m ? a : b; }
+	static SimdScalar round(SimdScalar a) {
+		float t = (float)(int)a.v;
+		float r = a.v - t; // exact
+		return {t + (r >= 0.5f ? 1.0f : 0.0f) - (r <= -0.5f ? 1.0f : 0.0f)};
+	}
+	static SimdScalar pow2i(SimdScalar n) {
+		uint32_t bits = (uint32_t)((int32_t)n.v + 127) << 23;
+		SimdScalar r;
+		memcpy(&r.v, &bits, sizeof(r.v));
+		return r;
+	}
+	static SimdScalar split(SimdScalar x, SimdScalar& exponent) {
+		uint32_t bits;
+		memcpy(&bits, &x.v, sizeof(bits));
+		exponent.v = (float)((int32_t)(bits >> 23) - 127);
+		bits = (bits & 0x007fffffu) | 0x3f800000u;
+		SimdScalar m;
+		memcpy(&m.v, &bits, sizeof(m.v));
+		return m;
+	}
+	static SimdScalar bipolar(const uint32_t *phase, uint32_t flip) { return {(int32_t)(*phase ^ flip) * (1.0f / 2147483648.0f)}; }
+	static void step(uint32_t *phase, const uint32_t *increment) { *phase += *increment; }
+};
+
+#if defined(__SSE2__)
+struct SimdSse2 {
+	static const int kWidth = 4;
+	typedef __m128 mask_t;
+	__m128 v;
+
+	static SimdSse2 load(const float *p) { return {_mm_loadu_ps(p)}; }
+	static void store(float *p, SimdSse2 a) { _mm_storeu_ps(p, a.v); }
+	static SimdSse2 splat(float x) { return {_mm_set1_ps(x)}; }
+	static SimdSse2 add(SimdSse2 a, SimdSse2 b) { return {_mm_add_ps(a.v, b.v)}; }
+	static SimdSse2 sub(SimdSse2 a, SimdSse2 b) { return {_mm_sub_ps(a.v, b.v)}; }
+	static SimdSse2 mul(SimdSse2 a, SimdSse2 b) { return {_mm_mul_ps(a.v, b.v)}; }
+	static SimdSse2 div(SimdSse2 a, SimdSse2 b) { return {_mm_div_ps(a.v, b.v)}; }
+	static SimdSse2 min(SimdSse2 a, SimdSse2 b) { return {_mm_min_ps(a.v, b.v)}; }
+	static SimdSse2 max(SimdSse2 a, SimdSse2 b) { return {_mm_max_ps(a.v, b.v)}; }
+	static SimdSse2 abs(SimdSse2 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+	static mask_t less(SimdSse2 a, SimdSse2 b) { return _mm_cmplt_ps(a.v, b.v); }
+	static SimdSse2 select(mask_t m, SimdSse2 a, SimdSse2 b) { return {_mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v))}; }
+	static SimdSse2 round(SimdSse2 a) {
+		__m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+		__m128 r = _mm_sub_ps(a.v, t);
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 up = _mm_and_ps(_mm_cmpge_ps(r, _mm_set1_ps(0.5f)), one);
+		__m128 down = _mm_and_ps(_mm_cmple_ps(r, _mm_set1_ps(-0.5f)), one);
+		return {_mm_sub_ps(_mm_add_ps(t, up), down)};
+	}
+	static SimdSse2 pow2i(SimdSse2 n) {
+		return {_mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127)), 23))};
+	}
+	static SimdSse2 split(SimdSse2 x, SimdSse2& exponent) {
+		__m128i bits = _mm_castps_si128(x.v);
+		exponent.v = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+		return {_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)))};
+	}
+	static SimdSse2 bipolar(const uint32_t *phase, uint32_t flip) {
+		__m128i bits = _mm_xor_si128(_mm_loadu_si128((const __m128i *)phase), _mm_set1_epi32(flip));
+		return {_mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.0f / 2147483648.0f))};
+	}
+	static void step(uint32_t *phase, const uint32_t *increment) {
+		__m128i p = _mm_loadu_si128((const __m128i *)phase);
+		_mm_storeu_si128((__m128i *)phase, _mm_add_epi32(p, _mm_loadu_si128((const __m128i *)increment)));
+	}
+};
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+struct SimdNeon {
+	static const int kWidth = 4;
+	typedef uint32x4_t mask_t;
+	float32x4_t v;
+
+	static SimdNeon load(const float *p) { return {vld1q_f32(p)}; }
+	static void store(float *p, SimdNeon a) { vst1q_f32(p, a.v); }
+	static SimdNeon splat(float x) { return {vdupq_n_f32(x)}; }
+	static SimdNeon add(SimdNeon a, SimdNeon b) { return {vaddq_f32(a.v, b.v)}; }
+	static SimdNeon sub(SimdNeon a, SimdNeon b) { return {vsubq_f32(a.v, b.v)}; }
+	static SimdNeon mul(SimdNeon a, SimdNeon b) { return {vmulq_f32(a.v, b.v)}; }
+	static SimdNeon div(SimdNeon a, SimdNeon b) {
+		// ARMv7 NEON has no divide, refine the reciprocal estimate twice
+		float32x4_t r = vrecpeq_f32(b.v);
+		r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+		r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+		return {vmulq_f32(a.v, r)};
+	}
+	static SimdNeon min(SimdNeon a, SimdNeon b) { return {vminq_f32(a.v, b.v)}; }
+	static SimdNeon max(SimdNeon a, SimdNeon b) { return {vmaxq_f32(a.v, b.v)}; }
+	static SimdNeon abs(SimdNeon a) { return {vabsq_f32(a.v)}; }
+	static mask_t less(SimdNeon a, SimdNeon b) { return vcltq_f32(a.v, b.v); }
+	static SimdNeon select(mask_t m, SimdNeon a, SimdNeon b) { return {vbslq_f32(m, a.v, b.v)}; }
+	static SimdNeon round(SimdNeon a) {
+		float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(a.v)); // the conversion truncates
+		float32x4_t r = vsubq_f32(a.v, t);
+		float32x4_t one = vdupq_n_f32(1.0f), zero = vdupq_n_f32(0.0f);
+		float32x4_t up = vbslq_f32(vcgeq_f32(r, vdupq_n_f32(0.5f)), one, zero);
+		float32x4_t down = vbslq_f32(vcleq_f32(r, vdupq_n_f32(-0.5f)), one, zero);
+		return {vsubq_f32(vaddq_f32(t, up), down)};
+	}
+	static SimdNeon pow2i(SimdNeon n) {
+		return {vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n.v), vdupq_n_s32(127)), 23))};
+	}
+	static SimdNeon split(SimdNeon x, SimdNeon& exponent) {
+		int32x4_t bits = vreinterpretq_s32_f32(x.v);
+		exponent.v = vcvtq_f32_s32(vsubq_s32(vshrq_n_s32(bits, 23), vdupq_n_s32(127)));
+		return {vreinterpretq_f32_s32(vorrq_s32(vandq_s32(bits, vdupq_n_s32(0x007fffff)), vdupq_n_s32(0x3f800000)))};
+	}
+	static SimdNeon bipolar(const uint32_t *phase, uint32_t flip) {
+		int32x4_t bits = vreinterpretq_s32_u32(veorq_u32(vld1q_u32(phase), vdupq_n_u32(flip)));
+		return {vcvtq_n_f32_s32(bits, 31)}; // fixed-point conversion, 31 fractional bits
+	}
+	static void step(uint32_t *phase, const uint32_t *increment) { vst1q_u32(phase, vaddq_u32(vld1q_u32(phase), vld1q_u32(increment))); }
+};
+#endif
+
+#if SIMD_HAVE_AVX2
+// Only call from code built for AVX2, after simdLevelSupported(SIMD_AVX2)
+struct SimdAvx2 {
+	static const int kWidth = 8;
+	typedef __m256 mask_t;
+	__m256 v;
+
+	SIMD_TARGET_AVX2 static SimdAvx2 load(const float *p) { return {_mm256_loadu_ps(p)}; }
+	SIMD_TARGET_AVX2 static void store(float *p, SimdAvx2 a) { _mm256_storeu_ps(p, a.v); }
+	SIMD_TARGET_AVX2 static SimdAvx2 splat(float x) { return {_mm256_set1_ps(x)}; }
+	SIMD_TARGET_AVX2 static SimdAvx2 add(SimdAvx2 a, SimdAvx2 b) { return {_mm256_add_ps(a.v, b.v)}; }
+	SIMD_TARGET_AVX2 static SimdAvx2 sub(SimdAvx2 a, SimdAvx2 b) { return {_mm256_sub_ps(a.v, b.v)}; }
+	SIMD_TARGET_AVX2 static SimdAvx2 mul(SimdAvx2 a, SimdAvx2 b) { return {_mm256_mul_ps(a.v, b.v)}; }
+	SIMD_TARGET_AVX2 static SimdAvx2 div(SimdAvx2 a, SimdAvx2 b) { return {_mm256_div_ps(a.v, b.v)}; }
+	SIMD_TARGET_AVX2 static SimdAvx2 min(SimdAvx2 a, SimdAvx2 b) { return {_mm256_min_ps(a.v, b.v)}; }
+	SIMD_TARGET_AVX2 static SimdAvx2 max(SimdAvx2 a, SimdAvx2 b) { return {_mm256_max_ps(a.v, b.v)}; }
+	SIMD_TARGET_AVX2 static SimdAvx2 abs(SimdAvx2 a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+	SIMD_TARGET_AVX2 static mask_t less(SimdAvx2 a, SimdAvx2 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+	SIMD_TARGET_AVX2 static SimdAvx2 select(mask_t m, SimdAvx2 a, SimdAvx2 b) { return {_mm256_blendv_ps(b.v, a.v, m)}; }
+	SIMD_TARGET_AVX2 static SimdAvx2 round(SimdAvx2 a) {
+		__m256 t = _mm256_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+		__m256 r = _mm256_sub_ps(a.v, t);
+		__m256 one = _mm256_set1_ps(1.0f);
+		__m256 up = _mm256_and_ps(_mm256_cmp_ps(r, _mm256_set1_ps(0.5f), _CMP_GE_OQ), one);
+		__m256 down = _mm256_and_ps(_mm256_cmp_ps(r, _mm256_set1_ps(-0.5f), _CMP_LE_OQ), one);
+		return {_mm256_sub_ps(_mm256_add_ps(t, up), down)};
+	}
+	SIMD_TARGET_AVX2 static SimdAvx2 pow2i(SimdAvx2 n) {
+		return {_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n.v), _mm256_set1_epi32(127)), 23))};
+	}
+	SIMD_TARGET_AVX2 static SimdAvx2 split(SimdAvx2 x, SimdAvx2& exponent) {
+		__m256i bits = _mm256_castps_si256(x.v);
+		exponent.v = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+		return {_mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)))};
+	}
+	SIMD_TARGET_AVX2 static SimdAvx2 bipolar(const uint32_t *phase, uint32_t flip) {
+		__m256i bits = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)phase), _mm256_set1_epi32(flip));
+		return {_mm256_mul_ps(_mm256_cvtepi32_ps(bits), _mm256_set1_ps(1.0f / 2147483648.0f))};
+	}
+	SIMD_TARGET_AVX2 static void step(uint32_t *phase, const uint32_t *increment) {
+		__m256i p = _mm256_loadu_si256((const __m256i *)phase);
+		_mm256_storeu_si256((__m256i *)phase, _mm256_add_epi32(p, _mm256_loadu_si256((const __m256i *)increment)));
+	}
+};
+#endif
+
+// widest backend every CPU of the target has, what the 4-lane banks run at unless the level is SIMD_SCALAR
+#if defined(__SSE2__)
+typedef SimdSse2 SimdBaseline;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+typedef SimdNeon SimdBaseline;
+#else
+typedef SimdScalar SimdBaseline;
+#endif
@@ -1,9 +1,12 @@
 /* SawAntiAlias.cpp: implements sawtooth waveform generator class with reduced aliasing
  * Sara Adkins
  */
+#include <algorithm>
 #include <cmath>
 #include "SquareAntiAlias.h"
-#include <Bela.h>
+
+// second saw is rendered into a scratch buffer in chunks of this many samples
+static const int kChunkSize = 64;
 
 SquareAntiAlias::SquareAntiAlias(float sampleRate) {
 	setup(sampleRate);
@@ -31,4 +34,26 @@ float SquareAntiAlias::getFrequency() {
 float SquareAntiAlias::process() {
 	//algorithm from Valimaki 2006
 	return saw1_.process() - saw2_.process();
-}	
\ No newline at end of file
+}
+
+void SquareAntiAlias::processBlock(float *out, int numFrames) {
+	float saw2[kChunkSize];
+	for(int start = 0; start < numFrames; start += kChunkSize) {
+		int len = std::min(kChunkSize, numFrames - start);
+		saw1_.processBlock(out + start, len);
+		saw2_.processBlock(saw2, len);
+		for(int n = 0; n < len; n++)
+			out[start + n] -= saw2[n];
+	}
+}
+
+void SquareAntiAlias::processBlock(float *out, const float *frequency, int numFrames) {
+	float saw2[kChunkSize];
+	for(int start = 0; start < numFrames; start += kChunkSize) {
+		int len = std::min(kChunkSize, numFrames - start);
+		saw1_.processBlock(out + start, frequency + start, len);
+		saw2_.processBlock(saw2, frequency + start, len);
+		for(int n = 0; n < len; n++)
+			out[start + n] -= saw2[n];
+	}
+}
@@ -3,7 +3,6 @@
  */
 #pragma once
 
-#include <vector>
 #include "SawAntiAlias.h"
 
 class SquareAntiAlias {
@@ -17,6 +16,8 @@ public:
 	float getFrequency(); // Get the oscillator frequency
 	
 	float process(); // Get the next sample and update the phase
+	void processBlock(float *out, int numFrames); // Fill a block at the current frequency
+	void processBlock(float *out, const float *frequency, int numFrames); // Fill a block, frequency set per sample
 	
 	~SquareAntiAlias() {} // Destructor
 
@@ -0,0 +1,25 @@
+/* SubharmonicDivider.cpp: implements the phase-locked subharmonic divider
+ */
+#include "SubharmonicDivider.h"
+#include <algorithm>
+#include <cmath>
+
+void SubharmonicDivider::setup() {
+	divisor_ = 1;
+	count_ = 0;
+	step_ = 0xFFFFFFFFu;
+}
+
+void SubharmonicDivider::setDivisor(int divisor, uint32_t vcoPhase) {
+	divisor = std::max(1, std::min((int)kMaxDivisor, divisor)); // copied, so the constant needs no definition
+	if((uint32_t)divisor == divisor_)
+		return;
+	// the subharmonic is at (count + p) / divisor of its cycle, p being the VCO phase in cycles. Keep that
+	// position for the new divisor as closely as whole VCO cycles allow, so the change does not click
+	float p = vcoPhase / kPhaseCycle;
+	float position = (count_ + p) / divisor_;
+	int count = (int)floorf(position * divisor - p + 0.5f);
+	count_ = std::max(0, std::min(divisor - 1, count));
+	divisor_ = divisor;
+	step_ = (divisor == 1) ? 0xFFFFFFFFu : (uint32_t)(4294967296ull / divisor);
+}
@@ -0,0 +1,53 @@
+/* SubharmonicDivider.h: 32-bit fixed-point oscillator phase and the divider that derives a subharmonic from it
+ * One cycle is 2^32, so the phase wraps by integer overflow without a branch. Like the analog divider, a
+ * subharmonic counts the wraps of its VCO modulo its divisor, and its phase is computed from that count and the
+ * VCO phase, so it stays locked to the VCO instead of drifting on an accumulator of its own
+ */
+#pragma once
+
+#include <cstdint>
+
+const float kPhaseCycle = 4294967296.0f; // 2^32, one cycle of a fixed-point phase
+
+// phase step per sample, for frequencies below the sample rate
+static inline uint32_t phaseIncrement(float frequency, float inverseSampleRate) {
+	return (uint32_t)(frequency * inverseSampleRate * kPhaseCycle);
+}
+
+// phase as a [-1, 1) ramp, the input of the DPW parabola. Flipping the top bit first gives the ramp of the
+// phase half a cycle later, as used by the second saw of a square
+static inline float bipolarPhase(uint32_t phase) {
+	return (int32_t)(phase ^ 0x80000000u) * (1.0f / 2147483648.0f);
+}
+
+class SubharmonicDivider {
+public:
+	static const int kMaxDivisor = 16;
+
+	SubharmonicDivider() {} // Default constructor
+
+	void setup(); // divide by 1, in phase with the VCO
+
+	// change the divisor, picking the count that keeps the subharmonic closest to its current phase
+	void setDivisor(int divisor, uint32_t vcoPhase);
+	int getDivisor() const { return divisor_; }
+
+	// subharmonic phase for the current VCO phase, count * 2^32 / divisor + vcoPhase / divisor
+	uint32_t getPhase(uint32_t vcoPhase) const {
+		return count_ * step_ + (uint32_t)(((uint64_t)vcoPhase * step_) >> 32);
+	}
+	uint32_t getIncrement(uint32_t vcoIncrement) const { return (uint32_t)(((uint64_t)vcoIncrement * step_) >> 32); }
+
+	// call after every VCO step, wrapped is true when the VCO phase passed the end of a cycle
+	void advance(bool wrapped) {
+		count_ += wrapped;
+		count_ = (count_ >= divisor_) ? 0 : count_;
+	}
+
+	~SubharmonicDivider() {} // Destructor
+
+private:
+	uint32_t divisor_;
+	uint32_t count_; // VCO cycles since the subharmonic's last wrap
+	uint32_t step_; // 2^32 / divisor, rounded down and kept below 2^32 when dividing by 1
+};
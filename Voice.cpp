@@ -0,0 +1,107 @@
+/* Voice.cpp: implements a single synth voice
+ */
+#include "Voice.h"
+#include <cmath>
+
+static bool gStereoOutput = STEREO_OUTPUT;
+static float gStereoWidth = STEREO_WIDTH;
+static float gStereoCutoffOffset = STEREO_CUTOFF_OFFSET;
+
+bool getStereoOutput() {
+	return gStereoOutput;
+}
+
+float getStereoWidth() {
+	return gStereoWidth;
+}
+
+float getStereoCutoffOffset() {
+	return gStereoCutoffOffset;
+}
+
+bool setStereoOutput(bool stereo, float width, float cutoffOffset) {
+	if(!(width >= 0.0f && width <= 1.0f))
+		return false;
+	gStereoOutput = stereo;
+	gStereoWidth = width;
+	gStereoCutoffOffset = cutoffOffset;
+	return true;
+}
+
+void Voice::setup(float sampleRate, int oversampling) {
+	oversampling_ = oversampling;
+	osc1_.setup(sampleRate, SAW);
+	osc2_.setup(sampleRate, SAW);
+	osc1_.setFrequency(kMinVcoFreq, 0.0f, 0.0f); // a voice can be rendered before it first follows the knobs
+	osc2_.setFrequency(kMinVcoFreq, 0.0f, 0.0f);
+	bank_.setup(sampleRate * oversampling);
+	bank_.setOversampling(oversampling);
+	float angle = (1.0f - getStereoWidth()) * (float)M_PI_4; // pi/4 is the centre, 0 a single side
+	panNear_ = cosf(angle);
+	panFar_ = sinf(angle);
+	amplitudeASR_.setSampleRate(sampleRate);
+	filterASR_.setSampleRate(sampleRate);
+	amplitudeASR_.setCurve(getDefaultEnvelopeCurve());
+	filterASR_.setCurve(getDefaultEnvelopeCurve());
+}
+
+void Voice::trigger() {
+	amplitudeASR_.trigger();
+	filterASR_.trigger();
+}
+
+void Voice::release() {
+	amplitudeASR_.release();
+	filterASR_.release();
+}
+
+void Voice::setEnvelopeTimes(float ampAttack, float ampRelease, float filterAttack, float filterRelease) {
+	amplitudeASR_.setAttackTime(ampAttack);
+	amplitudeASR_.setReleaseTime(ampRelease);
+	filterASR_.setAttackTime(filterAttack);
+	filterASR_.setReleaseTime(filterRelease);
+}
+
+void Voice::setSustainMode(bool doSustain) {
+	amplitudeASR_.setSustainMode(doSustain);
+	filterASR_.setSustainMode(doSustain);
+}
+
+void Voice::processEnvelopes(float *amplitude, float *filterEnvelope, int numFrames) {
+	amplitudeASR_.processBlock(amplitude, numFrames);
+	filterASR_.processBlock(filterEnvelope, numFrames);
+}
+
+void Voice::processOscillators(float *out, const float *frequencies, const float *gains, int numFrames) {
+	bank_.setWaveType(0, osc1_.getWaveType());
+	bank_.setWaveType(1, osc2_.getWaveType());
+	const int chunkFrames = kChunkSize / oversampling_;
+	for(int start = 0; start < numFrames; start += chunkFrames) {
+		int frames = numFrames - start < chunkFrames ? numFrames - start : chunkFrames;
+		int n = frames * oversampling_;
+		const int offset = start * OscillatorBank::kNumLanes;
+		bank_.processBlock(out1_, out2_, frequencies + offset, gains + offset, n);
+		float *chunk = out + start * oversampling_;
+		for(int i = 0; i < n; i++) {
+			chunk[i] = out1_[i] + out2_[i];
+		}
+	}
+}
+
+void Voice::processOscillators(float *left, float *right, const float *frequencies, const float *gains, int numFrames) {
+	bank_.setWaveType(0, osc1_.getWaveType());
+	bank_.setWaveType(1, osc2_.getWaveType());
+	const int chunkFrames = kChunkSize / oversampling_;
+	for(int start = 0; start < numFrames; start += chunkFrames) {
+		int frames = numFrames - start < chunkFrames ? numFrames - start : chunkFrames;
+		int n = frames * oversampling_;
+		const int offset = start * OscillatorBank::kNumLanes;
+		bank_.processBlock(out1_, out2_, frequencies + offset, gains + offset, n);
+		float *chunkLeft = left + start * oversampling_;
+		float *chunkRight = right + start * oversampling_;
+		for(int i = 0; i < n; i++) {
+			chunkLeft[i] = panNear_ * out1_[i] + panFar_ * out2_[i];
+			chunkRight[i] = panFar_ * out1_[i] + panNear_ * out2_[i];
+		}
+	}
+}
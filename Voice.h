@@ -0,0 +1,76 @@
+/* Voice.h: one note of the synth, both VCOs with their subharmonics, the filter and both envelopes
+ * The pitch is held by the voice's Oscillators, so a releasing voice keeps the note it was playing. In stereo
+ * mode VCO1 is panned left and VCO2 right, and render.cpp gives each side its own ladder
+ */
+#pragma once
+
+#include "Oscillator.h"
+#include "OscillatorBank.h"
+#include "ASR.h"
+
+#ifndef STEREO_OUTPUT
+#define STEREO_OUTPUT 0
+#endif
+#ifndef STEREO_WIDTH
+#define STEREO_WIDTH 0.8f
+#endif
+#ifndef STEREO_CUTOFF_OFFSET
+#define STEREO_CUTOFF_OFFSET 0.5f
+#endif
+
+// stereo mode used by setup(), STEREO_OUTPUT, STEREO_WIDTH and STEREO_CUTOFF_OFFSET until set. The width runs
+// from 0, both VCOs in the centre, to 1, VCO1 hard left and VCO2 hard right. The cutoff offset is in octaves
+// between the two ladders, the left one is lowered and the right one raised by half of it
+bool getStereoOutput();
+float getStereoWidth();
+float getStereoCutoffOffset();
+bool setStereoOutput(bool stereo, float width, float cutoffOffset); // false for a width outside [0, 1]
+
+class Voice {
+public:
+	Voice() {} // Default constructor
+	
+	void setup(float sampleRate, int oversampling = 1); // oscillators run at oversampling times the sample rate
+	
+	void trigger(); // start both envelopes
+	void release(); // release both envelopes
+	bool isActive() { return amplitudeASR_.isActive(); } // false once the amplitude envelope has closed
+	bool isAttacking() { return amplitudeASR_.isAttacking(); }
+	float getLevel() { return amplitudeASR_.getLevel(); }
+	
+	void setEnvelopeTimes(float ampAttack, float ampRelease, float filterAttack, float filterRelease);
+	void setSustainMode(bool doSustain);
+	
+	Oscillator* getOsc1() { return &osc1_; }
+	Oscillator* getOsc2() { return &osc2_; }
+	
+	// mute levels for each VCO, set while the voice follows the sequences and held afterwards
+	void setLevels(float level1, float level2) { level1_ = level1; level2_ = level2; }
+	float getLevel1() { return level1_; }
+	float getLevel2() { return level2_; }
+	
+	void processEnvelopes(float *amplitude, float *filterEnvelope, int numFrames); // render both envelopes
+	
+	// render both VCOs and their subharmonics mixed together, frame n reads OscillatorBank::kNumLanes
+	// frequencies and gains from frequencies/gains + n * kNumLanes. out gets numFrames * getOversampling() samples
+	void processOscillators(float *out, const float *frequencies, const float *gains, int numFrames);
+	// the same panned to two sides by constant power gains, from the stereo width at setup()
+	void processOscillators(float *left, float *right, const float *frequencies, const float *gains, int numFrames);
+	int getOversampling() { return oversampling_; }
+	
+	~Voice() {} // Destructor
+
+private:
+	Oscillator osc1_, osc2_;
+	OscillatorBank bank_;
+	ASR amplitudeASR_, filterASR_;
+	float level1_ = 1.0f;
+	float level2_ = 1.0f;
+	int oversampling_ = 1;
+	float panNear_ = 1.0f; // gain of each VCO on its own side
+	float panFar_ = 0.0f; // and on the other one
+	
+	static const int kChunkSize = 64; // samples mixed per bank call
+	float out1_[kChunkSize];
+	float out2_[kChunkSize];
+};
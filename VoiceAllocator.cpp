@@ -0,0 +1,71 @@
+/* VoiceAllocator.cpp: implements voice allocation and stealing
+ */
+#include "VoiceAllocator.h"
+
+void VoiceAllocator::setup(float sampleRate, int numVoices, int oversampling) {
+	if(numVoices < 1)
+		numVoices = 1;
+	else if(numVoices > kMaxVoices)
+		numVoices = kMaxVoices;
+	numVoices_ = numVoices;
+	for(int i = 0; i < numVoices_; i++) {
+		voices_[i].setup(sampleRate, oversampling);
+		startTimes_[i] = 0;
+	}
+	noteCount_ = 0;
+	current_ = 0;
+}
+
+int VoiceAllocator::findVoice() {
+	// the silent voice that has been free the longest
+	int best = -1;
+	for(int i = 0; i < numVoices_; i++) {
+		if(!voices_[i].isActive() && (best < 0 || startTimes_[i] < startTimes_[best]))
+			best = i;
+	}
+	if(best >= 0)
+		return best;
+	
+	// otherwise steal the quietest voice, keeping the current one unless it is the only voice
+	for(int i = 0; i < numVoices_; i++) {
+		if(i == current_ && numVoices_ > 1)
+			continue;
+		if(best < 0 || voices_[i].getLevel() < voices_[best].getLevel())
+			best = i;
+	}
+	return best;
+}
+
+void VoiceAllocator::trigger() {
+	Voice *current = getCurrent();
+	if(current->isAttacking())
+		return;
+	
+	int next = findVoice();
+	if(next != current_) {
+		// the new note starts from the pitch and levels the current voice is following
+		Voice *voice = &voices_[next];
+		*voice->getOsc1() = *current->getOsc1();
+		*voice->getOsc2() = *current->getOsc2();
+		voice->setLevels(current->getLevel1(), current->getLevel2());
+		current_ = next;
+	}
+	startTimes_[current_] = ++noteCount_;
+	voices_[current_].trigger();
+}
+
+void VoiceAllocator::release() {
+	getCurrent()->release();
+}
+
+void VoiceAllocator::setEnvelopeTimes(float ampAttack, float ampRelease, float filterAttack, float filterRelease) {
+	for(int i = 0; i < numVoices_; i++) {
+		voices_[i].setEnvelopeTimes(ampAttack, ampRelease, filterAttack, filterRelease);
+	}
+}
+
+void VoiceAllocator::setSustainMode(bool doSustain) {
+	for(int i = 0; i < numVoices_; i++) {
+		voices_[i].setSustainMode(doSustain);
+	}
+}
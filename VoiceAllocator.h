@@ -0,0 +1,39 @@
+/* VoiceAllocator.h: hands out voices so a new note can start while earlier ones release
+ * The newest voice is the current one, it follows the knobs and sequences, older voices hold their pitch
+ */
+#pragma once
+
+#include "Voice.h"
+
+class VoiceAllocator {
+public:
+	static const int kMaxVoices = 8;
+	
+	VoiceAllocator() {} // Default constructor
+	
+	void setup(float sampleRate, int numVoices, int oversampling = 1); // oscillator oversampling, see Voice
+	
+	// start a note, reusing a silent voice or stealing the quietest one. A trigger while the current
+	// voice is still in its attack is ignored, like the single envelope of the Moog
+	void trigger();
+	void release(); // release the current voice
+	
+	void setEnvelopeTimes(float ampAttack, float ampRelease, float filterAttack, float filterRelease);
+	void setSustainMode(bool doSustain);
+	
+	int getNumVoices() { return numVoices_; }
+	Voice* getVoice(int index) { return &voices_[index]; }
+	Voice* getCurrent() { return &voices_[current_]; }
+	int getCurrentIndex() { return current_; }
+	
+	~VoiceAllocator() {} // Destructor
+
+private:
+	int findVoice(); // voice for the next note
+	
+	Voice voices_[kMaxVoices];
+	unsigned long startTimes_[kMaxVoices]; // note count when each voice was last triggered
+	unsigned long noteCount_;
+	int numVoices_;
+	int current_;
+};
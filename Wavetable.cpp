@@ -0,0 +1,155 @@
+/* Wavetable.cpp: builds, loads and maps the mipmapped oscillator tables
+ */
+#include "Wavetable.h"
+#include "Fft.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// file layout for map() and save(): this header, then the tables in memory order
+struct WavetableFileHeader {
+	char magic[8];
+	uint32_t tableSize;
+	uint32_t numLevels;
+	uint32_t numWaves;
+	uint32_t reserved;
+};
+static const char kWavetableMagic[8] = {'S', 'U', 'B', 'H', 'W', 'T', '0', '1'};
+
+Wavetables& Wavetables::shared() {
+	static Wavetables tables;
+	return tables;
+}
+
+Wavetables::Wavetables() : storage_((size_t)kNumWaves * kNumLevels * kStride), mapping_(nullptr), mappingSize_(0) {
+	tables_ = storage_.data();
+	// sawtooth rising from -1 to 1 and the square made of two of them half a cycle apart, as SquareAntiAlias
+	std::vector<std::complex<double> > saw(kMaxHarmonics + 1), square(kMaxHarmonics + 1);
+	for(int h = 1; h <= kMaxHarmonics; h++) {
+		saw[h] = std::complex<double>(0.0, 2.0 / (M_PI * h)); // -2/(pi h) sin
+		square[h] = (h & 1) ? std::complex<double>(0.0, 4.0 / (M_PI * h)) : 0.0;
+	}
+	build(0, saw);
+	build(1, square);
+	build(2, saw);
+}
+
+Wavetables::~Wavetables() {
+	if(mapping_)
+		munmap(mapping_, mappingSize_);
+}
+
+void Wavetables::build(int wave, const std::vector<std::complex<double> >& harmonics) {
+	std::vector<std::complex<double> > x(kTableSize);
+	for(int level = 0; level < kNumLevels; level++) {
+		int numHarmonics = std::min((int)harmonics.size() - 1, kMaxHarmonics >> level);
+		std::fill(x.begin(), x.end(), 0.0);
+		for(int h = 1; h <= numHarmonics; h++) {
+			x[h] = harmonics[h] * 0.5;
+			x[kTableSize - h] = std::conj(harmonics[h]) * 0.5;
+		}
+		fft(x, 1);
+		float *table = storage_.data() + ((size_t)wave * kNumLevels + level) * kStride;
+		for(int i = 0; i < kTableSize; i++)
+			table[i] = (float)x[i].real();
+		table[kTableSize] = table[0];
+	}
+}
+
+bool Wavetables::setSingleCycle(int wave, const float *samples, int numSamples) {
+	if(wave < 0 || wave >= kNumWaves || numSamples < 2)
+		return false;
+	unmap();
+	// harmonics of the cycle by direct DFT, the cycle can be any length. DC is dropped
+	int numHarmonics = std::min((int)kMaxHarmonics, numSamples / 2); // copied, so the constant needs no definition
+	std::vector<std::complex<double> > harmonics(numHarmonics + 1, 0.0);
+	for(int h = 1; h <= numHarmonics; h++) {
+		std::complex<double> sum = 0.0;
+		for(int n = 0; n < numSamples; n++)
+			sum += (double)samples[n] * std::polar(1.0, -2.0 * M_PI * h * n / numSamples);
+		harmonics[h] = sum * (2.0 / numSamples);
+	}
+	if(numSamples % 2 == 0)
+		harmonics[numSamples / 2] *= 0.5; // the Nyquist bin of the cycle is not a conjugate pair
+	build(wave, harmonics);
+
+	// normalise the full bandwidth level to a peak of 1, the levels above share its gain
+	float *first = storage_.data() + (size_t)wave * kNumLevels * kStride;
+	float peak = 0.0f;
+	for(int i = 0; i < kTableSize; i++)
+		peak = std::max(peak, fabsf(first[i]));
+	if(peak > 0.0f) {
+		for(int i = 0; i < kNumLevels * kStride; i++)
+			first[i] /= peak;
+	}
+	return true;
+}
+
+bool Wavetables::loadSingleCycle(int wave, const std::string& path) {
+	std::ifstream file(path);
+	if(!file)
+		return false;
+	std::vector<float> samples;
+	float value;
+	while(file >> value)
+		samples.push_back(value);
+	return setSingleCycle(wave, samples.data(), (int)samples.size());
+}
+
+bool Wavetables::map(const std::string& path) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
+	struct stat info;
+	size_t size = sizeof(WavetableFileHeader) + storage_.size() * sizeof(float);
+	if(fstat(fd, &info) != 0 || (size_t)info.st_size != size) {
+		close(fd);
+		return false;
+	}
+	void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(mapping == MAP_FAILED)
+		return false;
+	const WavetableFileHeader *header = (const WavetableFileHeader *)mapping;
+	if(memcmp(header->magic, kWavetableMagic, sizeof(kWavetableMagic)) != 0 || header->tableSize != kTableSize
+		|| header->numLevels != kNumLevels || header->numWaves != kNumWaves) {
+		munmap(mapping, size);
+		return false;
+	}
+	if(mapping_)
+		munmap(mapping_, mappingSize_);
+	mapping_ = mapping;
+	mappingSize_ = size;
+	tables_ = (const float *)(header + 1);
+	return true;
+}
+
+void Wavetables::unmap() {
+	if(!mapping_)
+		return;
+	std::copy(tables_, tables_ + storage_.size(), storage_.begin());
+	munmap(mapping_, mappingSize_);
+	mapping_ = nullptr;
+	tables_ = storage_.data();
+}
+
+bool Wavetables::save(const std::string& path) const {
+	FILE *file = fopen(path.c_str(), "wb");
+	if(!file)
+		return false;
+	WavetableFileHeader header;
+	memcpy(header.magic, kWavetableMagic, sizeof(kWavetableMagic));
+	header.tableSize = kTableSize;
+	header.numLevels = kNumLevels;
+	header.numWaves = kNumWaves;
+	header.reserved = 0;
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(tables_, sizeof(float), storage_.size(), file) == storage_.size();
+	return (fclose(file) == 0) && ok;
+}
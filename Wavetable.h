@@ -0,0 +1,90 @@
+/* Wavetable.h: mipmapped band-limited single-cycle tables for the oscillators
+ * Every wave is stored once per octave, each level holding half the harmonics of the one below, so a core reads
+ * the level whose highest harmonic stays under Nyquist at its increment. The level is picked from the leading
+ * zeros of the phase increment when the frequency changes, and each sample is one linearly interpolated lookup.
+ * Tables are built at startup, the user wave from a single-cycle file, or mapped from a file written by save()
+ */
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Wavetables {
+public:
+	static const int kTableBits = 12;
+	static const int kTableSize = 1 << kTableBits; // samples per cycle, twice the most harmonics a level holds
+	static const int kNumLevels = 11; // 1024 harmonics down to 1, one octave each
+	static const int kMaxHarmonics = 1 << (kNumLevels - 1);
+	static const int kNumWaves = 3; // indexed by WaveType: saw, square, user
+	static const int kStride = kTableSize + 1; // each level repeats its first sample to interpolate into
+
+	// tables shared by all oscillators, with the saw and square built and the user wave a saw until loaded
+	static Wavetables& shared();
+
+	// Replace the user wave (or any other) with one cycle of samples, any length from 2 up. Call from setup(),
+	// before the voices, never while render() is running
+	bool setSingleCycle(int wave, const float *samples, int numSamples);
+	bool loadSingleCycle(int wave, const std::string& path); // whitespace separated samples of one cycle
+
+	// map every table from a file written by save(), instead of building them. Same rules as setSingleCycle()
+	bool map(const std::string& path);
+	bool save(const std::string& path) const;
+
+	// level for a phase increment (2^32 per cycle): the first one whose harmonics all stay below Nyquist
+	static int level(uint32_t increment) {
+		if(increment <= (1u << (32 - kNumLevels)))
+			return 0;
+		int octave = 32 - __builtin_clz(increment - 1) - (32 - kNumLevels); // ceil(log2) above the first level
+		return octave < kNumLevels ? octave : kNumLevels - 1;
+	}
+	const float* getTable(int wave, int level) const { return tables_ + ((size_t)wave * kNumLevels + level) * kStride; }
+
+	~Wavetables();
+
+private:
+	Wavetables();
+
+	// fill every level of a wave from complex harmonic amplitudes, x(t) = Re sum c[h] e^(2 pi i h t), h from 1
+	void build(int wave, const std::vector<std::complex<double> >& harmonics);
+	void unmap(); // copy mapped tables into storage so they can be changed
+
+	std::vector<float> storage_; // [wave][level][kStride] when built
+	const float *tables_; // storage_ or the mapping
+	void *mapping_;
+	size_t mappingSize_;
+};
+
+// AntiAlias policy reading a Wavetables table, so the core renders its wave type directly: a square is one lookup
+// rather than the difference of two saws
+class WavetableCore {
+public:
+	WavetableCore() : tables_(&Wavetables::shared()), wave_(0), level_(0) { table_ = tables_->getTable(0, 0); }
+
+	void setWave(int wave) {
+		wave_ = wave;
+		table_ = tables_->getTable(wave_, level_);
+	}
+
+	void reset(uint32_t phase, uint32_t increment) { setIncrement(increment); }
+
+	void setIncrement(uint32_t increment) {
+		level_ = Wavetables::level(increment);
+		table_ = tables_->getTable(wave_, level_);
+	}
+
+	float process(uint32_t phase) {
+		const int shift = 32 - Wavetables::kTableBits;
+		uint32_t index = phase >> shift;
+		float frac = (phase & ((1u << shift) - 1)) * (1.0f / (1u << shift));
+		return table_[index] + frac * (table_[index + 1] - table_[index]);
+	}
+
+private:
+	const Wavetables *tables_;
+	const float *table_;
+	int wave_;
+	int level_;
+};
@@ -0,0 +1,116 @@
+/* AliasBenchmarks.cpp: cost and alias rejection of each band-limiting policy in AntiAlias.h
+ * Every case reports cycles per sample of one sawtooth core and, as metrics, the power of the aliases relative to
+ * the harmonics in dB: alias_db over the whole band and audible_db for aliases that fold below 10 kHz
+ */
+#ifdef HOST_BUILD
+
+#include "Benchmark.h"
+#include "../AntiAlias.h"
+#include "../Oscillator.h"
+#include <algorithm>
+#include <cmath>
+
+static const float kSampleRate = 44100.0f;
+static const float kFrequencies[] = {kMinVcoFreq, 1000.0f, 2500.0f, kMaxVcoFreq};
+static const int kAnalysisLength = 32768;
+static const int kSettleSamples = 4096; // skipped so start-up transients are not measured
+static const double kAudibleLimit = 10000.0;
+
+// power of a sinusoid at frequency (cycles per sample) in a windowed signal
+static double tonePower(const std::vector<double>& x, double frequency) {
+	double re = 0.0, im = 0.0;
+	double c = cos(2.0 * M_PI * frequency), s = sin(2.0 * M_PI * frequency);
+	double wr = 1.0, wi = 0.0;
+	for(size_t n = 0; n < x.size(); n++) {
+		re += x[n] * wr;
+		im -= x[n] * wi;
+		double t = wr * c - wi * s;
+		wi = wr * s + wi * c;
+		wr = t;
+	}
+	return re * re + im * im;
+}
+
+// Harmonic m of the sawtooth lands at m * f, above Nyquist it folds back as an alias. Each component is measured
+// by projection onto its exact frequency with a 4-term Blackman-Harris window, skipping aliases that land within
+// the window's main lobe of a harmonic or of DC
+AliasMeasurement measureAliasing(const std::vector<float>& signal, double frequency) {
+	const int n = (int)signal.size();
+	std::vector<double> x(n);
+	for(int i = 0; i < n; i++) {
+		double p = 2.0 * M_PI * i / (n - 1);
+		double window = 0.35875 - 0.48829 * cos(p) + 0.14128 * cos(2 * p) - 0.01168 * cos(3 * p);
+		x[i] = signal[i] * window;
+	}
+	const double f = frequency / kSampleRate;
+	const double guard = 4.0 / n; // main lobe half width
+	double harmonics = 0.0, aliases = 0.0, audible = 0.0;
+	for(int m = 1; m * f < 8.0; m++) {
+		double folded = fmod(m * f, 1.0);
+		folded = folded > 0.5 ? 1.0 - folded : folded;
+		if(m * f < 0.5) {
+			harmonics += tonePower(x, folded);
+			continue;
+		}
+		double nearest = std::max(1.0, floor(folded / f + 0.5)) * f;
+		if(fabs(folded - nearest) < guard || folded < guard || folded > 0.5 - guard)
+			continue;
+		double power = tonePower(x, folded);
+		aliases += power;
+		if(folded * kSampleRate < kAudibleLimit)
+			audible += power;
+	}
+	AliasMeasurement result;
+	result.aliasDb = 10.0 * log10(std::max(aliases, 1e-30) / harmonics);
+	result.audibleDb = 10.0 * log10(std::max(audible, 1e-30) / harmonics);
+	return result;
+}
+
+// the unfiltered ramp, as the reference the policies improve on
+struct NaiveSaw {
+	void reset(uint32_t phase, uint32_t increment) {}
+	float process(uint32_t phase) { return bipolarPhase(phase); }
+};
+
+template<typename Policy>
+static void benchPolicy(BenchmarkRunner& runner, const std::string& name) {
+	if(!runner.enabled(name))
+		return;
+	for(float frequency : kFrequencies) {
+		uint32_t increment = phaseIncrement(frequency, 1.0f / kSampleRate);
+		Policy saw;
+		saw.reset(0, increment);
+		uint32_t phase = 0;
+		std::vector<float> signal(kAnalysisLength);
+		for(int n = 0; n < kSettleSamples; n++, phase += increment)
+			saw.process(phase);
+		for(int n = 0; n < kAnalysisLength; n++, phase += increment)
+			signal[n] = saw.process(phase);
+		AliasMeasurement aliasing = measureAliasing(signal, frequency);
+
+		for(int blockSize : runner.getBlockSizes()) {
+			BenchmarkResult *result = runner.run(name, {{"freq", frequency}}, blockSize, [&](int n) {
+				float sum = 0.0f;
+				for(int i = 0; i < n; i++, phase += increment)
+					sum += saw.process(phase);
+				gBenchSink = sum;
+			});
+			if(result) {
+				result->metrics.push_back({"alias_db", aliasing.aliasDb});
+				result->metrics.push_back({"audible_db", aliasing.audibleDb});
+			}
+		}
+	}
+}
+
+void runAliasBenchmarks(BenchmarkRunner& runner) {
+	benchPolicy<NaiveSaw>(runner, "AntiAlias::naive");
+	benchPolicy<Dpw<2> >(runner, std::string("AntiAlias::") + antiAliasName(DPW2));
+	benchPolicy<Dpw<3> >(runner, std::string("AntiAlias::") + antiAliasName(DPW3));
+	benchPolicy<Dpw<4> >(runner, std::string("AntiAlias::") + antiAliasName(DPW4));
+	benchPolicy<PolyBlep>(runner, std::string("AntiAlias::") + antiAliasName(POLYBLEP));
+	benchPolicy<MinBlep>(runner, std::string("AntiAlias::") + antiAliasName(MINBLEP));
+	benchPolicy<WavetableCore>(runner, std::string("AntiAlias::") + antiAliasName(WAVETABLE));
+}
+
+#endif // HOST_BUILD
@@ -0,0 +1,65 @@
+// BenchMain.cpp: command line entry point for the DSP microbenchmarks
+//
+// Build from the project root:
+//   g++ -std=c++11 -O3 -DHOST_BUILD -I. *.cpp host/HostPlatform.cpp bench/*.cpp -o subharmonicon-bench
+#ifdef HOST_BUILD
+
+#include "Benchmark.h"
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <unistd.h>
+
+static void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [options]\n"
+		"  -f <substring>  only run benchmarks whose name contains this\n"
+		"  -b <list>       comma separated block sizes (16,32,64,128)\n"
+		"  -n <samples>    samples per repeat (1048576)\n"
+		"  -r <repeats>    repeats, the fastest is reported (5)\n"
+		"  -m <MHz>        clock used to estimate cycles without a counter (1000)\n"
+		"  -j <file>       write JSON results, '-' for stdout\n",
+		name);
+}
+
+int main(int argc, char *argv[])
+{
+	BenchmarkRunner runner;
+	std::string jsonPath;
+
+	int opt;
+	while((opt = getopt(argc, argv, "f:b:n:r:m:j:h")) != -1) {
+		switch(opt) {
+			case 'f': runner.setFilter(optarg); break;
+			case 'n': runner.setSamples(atol(optarg)); break;
+			case 'r': runner.setRepeats(atoi(optarg)); break;
+			case 'm': runner.setCpuMHz(atof(optarg)); break;
+			case 'j': jsonPath = optarg; break;
+			case 'b': {
+				std::vector<int> sizes;
+				std::stringstream list(optarg);
+				std::string item;
+				while(std::getline(list, item, ','))
+					if(atoi(item.c_str()) > 0)
+						sizes.push_back(atoi(item.c_str()));
+				runner.setBlockSizes(sizes);
+				break;
+			}
+			default: usage(argv[0]); return 1;
+		}
+	}
+
+	runDspBenchmarks(runner);
+	runAliasBenchmarks(runner);
+	runOversampleBenchmarks(runner);
+	bool accurate = runFastMathBenchmarks(runner);
+
+	if(jsonPath != "-")
+		runner.printTable();
+	if(!jsonPath.empty() && !runner.writeJson(jsonPath)) {
+		fprintf(stderr, "Error: cannot write %s\n", jsonPath.c_str());
+		return 1;
+	}
+	return accurate ? 0 : 1;
+}
+
+#endif // HOST_BUILD
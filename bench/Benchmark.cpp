@@ -0,0 +1,79 @@
+/* Benchmark.cpp: result bookkeeping and reporting for the DSP microbenchmarks
+ */
+#ifdef HOST_BUILD
+
+#include "Benchmark.h"
+#include <cstdio>
+
+volatile float gBenchSink = 0.0f;
+
+bool BenchmarkRunner::enabled(const std::string& name) {
+	return filter_.empty() || name.find(filter_) != std::string::npos;
+}
+
+const char* BenchmarkRunner::cycleSource() {
+	uint64_t unused;
+	return readCycleCounter(unused) ? "counter" : "estimated";
+}
+
+BenchmarkResult* BenchmarkRunner::record(const std::string& name, const BenchParams& params, int blockSize, long samples, double ns, double cycles, bool haveCycles) {
+	BenchmarkResult result;
+	result.name = name;
+	result.params = params;
+	result.blockSize = blockSize;
+	result.samples = samples;
+	result.nsPerSample = ns / samples;
+	// without a counter, estimate from the nominal clock of the target
+	result.cyclesPerSample = haveCycles ? cycles / samples : result.nsPerSample * cpuMHz_ / 1000.0;
+	results_.push_back(result);
+	return &results_.back();
+}
+
+static std::string formatParams(const BenchParams& params) {
+	std::string out;
+	char buf[64];
+	for(unsigned int i = 0; i < params.size(); i++) {
+		snprintf(buf, sizeof(buf), "%s%s=%g", i ? " " : "", params[i].first.c_str(), params[i].second);
+		out += buf;
+	}
+	return out;
+}
+
+void BenchmarkRunner::printTable() {
+	printf("%-36s %-28s %6s %10s %12s\n", "benchmark", "params", "block", "ns/sample", "cycles/sample");
+	for(BenchmarkResult& r : results_) {
+		printf("%-36s %-28s %6d %10.3f %12.2f", r.name.c_str(), formatParams(r.params).c_str(), r.blockSize, r.nsPerSample, r.cyclesPerSample);
+		if(!r.metrics.empty())
+			printf("  [%s]", formatParams(r.metrics).c_str());
+		printf("\n");
+	}
+}
+
+static void writeParamsJson(FILE *f, const char *key, const BenchParams& params) {
+	fprintf(f, ", \"%s\": {", key);
+	for(unsigned int i = 0; i < params.size(); i++)
+		fprintf(f, "%s\"%s\": %.9g", i ? ", " : "", params[i].first.c_str(), params[i].second);
+	fprintf(f, "}");
+}
+
+bool BenchmarkRunner::writeJson(const std::string& path) {
+	FILE *f = path == "-" ? stdout : fopen(path.c_str(), "w");
+	if(f == nullptr)
+		return false;
+	fprintf(f, "{\n  \"cycle_source\": \"%s\",\n  \"cpu_mhz\": %g,\n  \"repeats\": %d,\n  \"benchmarks\": [\n", cycleSource(), cpuMHz_, repeats_);
+	for(unsigned int i = 0; i < results_.size(); i++) {
+		BenchmarkResult& r = results_[i];
+		fprintf(f, "    {\"name\": \"%s\", \"block_size\": %d, \"samples\": %ld, \"ns_per_sample\": %.6g, \"cycles_per_sample\": %.6g",
+			r.name.c_str(), r.blockSize, r.samples, r.nsPerSample, r.cyclesPerSample);
+		writeParamsJson(f, "params", r.params);
+		if(!r.metrics.empty())
+			writeParamsJson(f, "metrics", r.metrics);
+		fprintf(f, "}%s\n", i + 1 < results_.size() ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	if(f != stdout)
+		fclose(f);
+	return true;
+}
+
+#endif // HOST_BUILD
@@ -0,0 +1,105 @@
+/* Benchmark.h: timing harness for the DSP microbenchmarks
+ * Runs a block callback until a sample budget is used, keeps the fastest repeat and reports
+ * ns and cycles per sample. Results can be written as JSON to diff between commits.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "CycleCounter.h"
+
+typedef std::vector<std::pair<std::string, double> > BenchParams;
+
+struct BenchmarkResult {
+	std::string name;
+	BenchParams params; // parameter sweep values for this run
+	BenchParams metrics; // extra measurements reported by the case (e.g. error, rejection)
+	int blockSize;
+	long samples; // samples processed per repeat
+	double nsPerSample;
+	double cyclesPerSample;
+};
+
+class BenchmarkRunner {
+public:
+	BenchmarkRunner() {}
+
+	void setSamples(long samples) { samples_ = samples; }
+	void setRepeats(int repeats) { repeats_ = repeats; }
+	void setFilter(const std::string& filter) { filter_ = filter; }
+	void setCpuMHz(double mhz) { cpuMHz_ = mhz; } // used to estimate cycles without a counter
+	void setBlockSizes(const std::vector<int>& sizes) { blockSizes_ = sizes; }
+
+	const std::vector<int>& getBlockSizes() { return blockSizes_; }
+	bool enabled(const std::string& name); // false if the name does not match the filter
+
+	// Time process(blockSize) over the sample budget, process must handle blockSize samples per call
+	template<typename F>
+	BenchmarkResult* run(const std::string& name, const BenchParams& params, int blockSize, F process);
+
+	void printTable();
+	bool writeJson(const std::string& path);
+	const char* cycleSource();
+
+private:
+	long samples_ = 1 << 20;
+	int repeats_ = 5;
+	double cpuMHz_ = 1000.0; // BeagleBone Black AM335x
+	std::string filter_;
+	std::vector<int> blockSizes_ = {16, 32, 64, 128};
+	std::vector<BenchmarkResult> results_;
+
+	BenchmarkResult* record(const std::string& name, const BenchParams& params, int blockSize, long samples, double ns, double cycles, bool haveCycles);
+};
+
+// keep optimised results alive
+extern volatile float gBenchSink;
+
+template<typename F>
+BenchmarkResult* BenchmarkRunner::run(const std::string& name, const BenchParams& params, int blockSize, F process) {
+	if(!enabled(name))
+		return nullptr;
+	long blocks = samples_ / blockSize;
+	if(blocks < 1)
+		blocks = 1;
+
+	// warm up caches and branch predictors
+	for(long b = 0; b < blocks / 8 + 1; b++)
+		process(blockSize);
+
+	double bestNs = 1e300;
+	double bestCycles = 1e300;
+	bool haveCycles = false;
+	for(int r = 0; r < repeats_; r++) {
+		uint64_t c0, c1;
+		auto t0 = std::chrono::steady_clock::now();
+		haveCycles = readCycleCounter(c0);
+		for(long b = 0; b < blocks; b++)
+			process(blockSize);
+		readCycleCounter(c1);
+		auto t1 = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+		if(ns < bestNs) {
+			bestNs = ns;
+			bestCycles = (double)(c1 - c0);
+		}
+	}
+	return record(name, params, blockSize, blocks * blockSize, bestNs, bestCycles, haveCycles);
+}
+
+// power of the aliases of a periodic signal at frequency Hz (44.1 kHz) relative to its harmonics, in dB, over
+// the whole band and below 10 kHz. See AliasBenchmarks.cpp
+struct AliasMeasurement {
+	double aliasDb;
+	double audibleDb;
+};
+AliasMeasurement measureAliasing(const std::vector<float>& signal, double frequency);
+
+// benchmark suites, each registers its cases with the runner
+void runDspBenchmarks(BenchmarkRunner& runner);
+void runAliasBenchmarks(BenchmarkRunner& runner);
+void runOversampleBenchmarks(BenchmarkRunner& runner);
+bool runFastMathBenchmarks(BenchmarkRunner& runner); // false if an approximation exceeds its documented bound
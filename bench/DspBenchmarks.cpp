@@ -0,0 +1,613 @@
+/* DspBenchmarks.cpp: per-class benchmarks for the oscillator, filter, envelope and sequence code
+ */
+#ifdef HOST_BUILD
+
+#include "Benchmark.h"
+#include "../Platform.h"
+#include "../SawAntiAlias.h"
+#include "../SquareAntiAlias.h"
+#include "../Oscillator.h"
+#include "../OscillatorBank.h"
+#include "../FOFilter.h"
+#include "../ResFilter.h"
+#include "../ResFilterBank.h"
+#include "../Oversampler.h"
+#include "../Voice.h"
+#include "../Simd.h"
+#include "../Fft.h"
+#include "../ASR.h"
+#include "../Sequence.h"
+#include "../ControlInput.h"
+#include "../ParameterStore.h"
+#include "../GuiProtocol.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const float kSampleRate = 44100.0f;
+static const float kFrequencies[] = {kMinVcoFreq, 1000.0f, kMaxVcoFreq};
+
+static void benchOscillatorCores(BenchmarkRunner& runner) {
+	for(int blockSize : runner.getBlockSizes()) {
+		std::vector<float> out(blockSize);
+		for(float freq : kFrequencies) {
+			SawAntiAlias saw(kSampleRate, 0.0f);
+			saw.setFrequency(freq);
+			runner.run("SawAntiAlias::process", {{"freq", freq}}, blockSize, [&](int n) {
+				float sum = 0.0f;
+				for(int i = 0; i < n; i++)
+					sum += saw.process();
+				gBenchSink = sum;
+			});
+			runner.run("SawAntiAlias::processBlock", {{"freq", freq}}, blockSize, [&](int n) {
+				saw.processBlock(out.data(), n);
+				gBenchSink = out[n - 1];
+			});
+
+			SquareAntiAlias square(kSampleRate);
+			square.setFrequency(freq);
+			runner.run("SquareAntiAlias::process", {{"freq", freq}}, blockSize, [&](int n) {
+				float sum = 0.0f;
+				for(int i = 0; i < n; i++)
+					sum += square.process();
+				gBenchSink = sum;
+			});
+			runner.run("SquareAntiAlias::processBlock", {{"freq", freq}}, blockSize, [&](int n) {
+				square.processBlock(out.data(), n);
+				gBenchSink = out[n - 1];
+			});
+		}
+	}
+}
+
+static void benchOscillator(BenchmarkRunner& runner) {
+	for(int blockSize : runner.getBlockSizes()) {
+		for(int wave = SAW; wave <= SQUARE; wave++) {
+			Oscillator osc(kSampleRate, (WaveType)wave);
+			osc.setSub1Ratio(2);
+			osc.setSub2Ratio(3);
+			osc.setFrequency(440.0f, 0, 0);
+			runner.run("Oscillator::process", {{"wave", wave}}, blockSize, [&](int n) {
+				float sum = 0.0f;
+				for(int i = 0; i < n; i++)
+					sum += osc.process(0.8f, 0.2f, 0.2f);
+				gBenchSink = sum;
+			});
+			std::vector<float> out(blockSize);
+			runner.run("Oscillator::processBlock", {{"wave", wave}}, blockSize, [&](int n) {
+				osc.processBlock(out.data(), n, 0.8f, 0.2f, 0.2f);
+				gBenchSink = out[n - 1];
+			});
+		}
+		for(int scale = NO_SCALE; scale <= PENTATONIC; scale++) {
+			Oscillator osc(kSampleRate, SAW);
+			osc.setScale((Scale)scale);
+			float freq = kMinVcoFreq;
+			runner.run("Oscillator::setFrequency", {{"scale", scale}}, blockSize, [&](int n) {
+				for(int i = 0; i < n; i++) {
+					osc.setFrequency(freq, 0, 0);
+					freq = freq < kMaxVcoFreq ? freq * 1.0001f : kMinVcoFreq; // sweep the knob range
+				}
+			});
+			// the same sweep with the scale tested once per block, in the bank's frame layout
+			std::vector<float> frames(blockSize * OscillatorBank::kNumLanes);
+			runner.run("Oscillator::setFrequencyBlock", {{"scale", scale}}, blockSize, [&](int n) {
+				for(int i = 0; i < n; i++) {
+					frames[i * OscillatorBank::kNumLanes] = freq;
+					freq = freq < kMaxVcoFreq ? freq * 1.0001f : kMinVcoFreq;
+				}
+				osc.setFrequencyBlock(frames.data(), OscillatorBank::kNumLanes, 0, 0, n);
+				gBenchSink = frames[0];
+			});
+		}
+	}
+}
+
+// both VCOs with two subharmonics each, the same work as two Oscillator::process calls, for each policy
+static void benchOscillatorBank(BenchmarkRunner& runner) {
+	for(int blockSize : runner.getBlockSizes()) {
+		for(int method = 0; method < kNumAntiAlias; method++) {
+			for(int wave = SAW; wave <= SQUARE; wave++) {
+				OscillatorBank bank(kSampleRate);
+				bank.setAntiAlias((AntiAlias)method);
+				for(int vco = 0; vco < OscillatorBank::kNumVcos; vco++) {
+					bank.setWaveType(vco, (WaveType)wave);
+					bank.setFrequencies(vco, 440.0f, 2, 3);
+					bank.setGains(vco, 0.8f, 0.2f, 0.2f);
+				}
+				runner.run("OscillatorBank::process", {{"method", method}, {"wave", wave}}, blockSize, [&](int n) {
+					float sum = 0.0f;
+					float out[OscillatorBank::kNumVcos];
+					for(int i = 0; i < n; i++) {
+						bank.process(out);
+						sum += out[0] + out[1];
+					}
+					gBenchSink = sum;
+				});
+				std::vector<float> out1(blockSize), out2(blockSize);
+				runner.run("OscillatorBank::processBlock", {{"method", method}, {"wave", wave}}, blockSize, [&](int n) {
+					bank.processBlock(out1.data(), out2.data(), n);
+					gBenchSink = out1[n - 1] + out2[n - 1];
+				});
+			}
+		}
+	}
+}
+
+// a modulated ladder of each compiled order, the loops over sections unroll for every one
+template<int Order>
+static void benchResFilterOrder(BenchmarkRunner& runner, int blockSize, const float *in, float *out, float *cutoffs, const float *resonances) {
+	ResFilter<Order> filter(kSampleRate);
+	float c = 1000.0f;
+	runner.run("ResFilter<Order>::processBlock/modulated", {{"order", Order}}, blockSize, [&](int n) {
+		for(int i = 0; i < n; i++) {
+			cutoffs[i] = c;
+			c = c < 2000.0f ? c * 1.0001f : 1000.0f;
+		}
+		filter.processBlock(out, in, cutoffs, resonances, n);
+		gBenchSink = out[n - 1];
+	});
+}
+
+static void benchFilters(BenchmarkRunner& runner) {
+	float noise = 0.0f;
+	for(int blockSize : runner.getBlockSizes()) {
+		std::vector<float> in(blockSize), out(blockSize), cutoffs(blockSize), resonances(blockSize, 0.5f);
+		for(int i = 0; i < blockSize; i++)
+			in[i] = (i % 32) / 16.0f - 1.0f;
+		FOFilter section(kSampleRate, 1000.0f, 0.5f);
+		runner.run("FOFilter::process", {}, blockSize, [&](int n) {
+			float sum = 0.0f;
+			for(int i = 0; i < n; i++) {
+				noise = noise * 0.99f + 0.01f; // cheap bounded input
+				sum += section.process(noise - 0.5f);
+			}
+			gBenchSink = sum;
+		});
+		runner.run("FOFilter::processBlock", {}, blockSize, [&](int n) {
+			section.processBlock(out.data(), in.data(), n);
+			gBenchSink = out[n - 1];
+		});
+
+		for(float res : {0.0f, 0.5f, 0.95f}) {
+			ResFilter<4> filter(kSampleRate);
+			filter.updateSections(kSampleRate, 1000.0f, res);
+			runner.run("ResFilter::process", {{"resonance", res}}, blockSize, [&](int n) {
+				float sum = 0.0f;
+				for(int i = 0; i < n; i++) {
+					noise = noise * 0.99f + 0.01f;
+					sum += filter.process(noise - 0.5f);
+				}
+				gBenchSink = sum;
+			});
+			runner.run("ResFilter::processBlock", {{"resonance", res}}, blockSize, [&](int n) {
+				filter.processBlock(out.data(), in.data(), n);
+				gBenchSink = out[n - 1];
+			});
+		}
+
+		for(float cutoff : {100.0f, 1000.0f, 10000.0f}) {
+			ResFilter<4> filter(kSampleRate);
+			float c = cutoff;
+			runner.run("ResFilter::updateSections", {{"cutoff", cutoff}}, blockSize, [&](int n) {
+				for(int i = 0; i < n; i++) {
+					filter.updateSections(kSampleRate, c, 0.5f);
+					c = c < cutoff * 2.0f ? c * 1.0001f : cutoff; // envelope-style sweep
+				}
+			});
+			runner.run("ResFilter::processBlock/modulated", {{"cutoff", cutoff}}, blockSize, [&](int n) {
+				for(int i = 0; i < n; i++) {
+					cutoffs[i] = c;
+					c = c < cutoff * 2.0f ? c * 1.0001f : cutoff;
+				}
+				filter.processBlock(out.data(), in.data(), cutoffs.data(), resonances.data(), n);
+				gBenchSink = out[n - 1];
+			});
+		}
+
+		benchResFilterOrder<1>(runner, blockSize, in.data(), out.data(), cutoffs.data(), resonances.data());
+		benchResFilterOrder<2>(runner, blockSize, in.data(), out.data(), cutoffs.data(), resonances.data());
+		benchResFilterOrder<3>(runner, blockSize, in.data(), out.data(), cutoffs.data(), resonances.data());
+		benchResFilterOrder<4>(runner, blockSize, in.data(), out.data(), cutoffs.data(), resonances.data());
+
+		// four modulated voices, one ResFilter each against one lane each of a ResFilterBank
+		const int lanes = ResFilterBank::kNumLanes;
+		std::vector<float> laneIn(blockSize * lanes), laneOut(blockSize * lanes), laneCutoffs(blockSize * lanes);
+		for(int i = 0; i < blockSize * lanes; i++)
+			laneIn[i] = in[i / lanes];
+		ResFilter<4> voiceFilters[lanes];
+		for(int l = 0; l < lanes; l++)
+			voiceFilters[l].setup(kSampleRate);
+		float c = 1000.0f;
+		runner.run("ResFilter::processBlock/4 voices", {}, blockSize, [&](int n) {
+			for(int l = 0; l < lanes; l++) {
+				for(int i = 0; i < n; i++) {
+					cutoffs[i] = c * (l + 1);
+					c = c < 2000.0f ? c * 1.0001f : 1000.0f;
+				}
+				voiceFilters[l].processBlock(out.data(), in.data(), cutoffs.data(), resonances.data(), n);
+			}
+			gBenchSink = out[n - 1];
+		});
+		ResFilterBank bank(kSampleRate);
+		runner.run("ResFilterBank::processBlock", {}, blockSize, [&](int n) {
+			for(int i = 0; i < n; i++) {
+				for(int l = 0; l < lanes; l++)
+					laneCutoffs[i * lanes + l] = c * (l + 1);
+				c = c < 2000.0f ? c * 1.0001f : 1000.0f;
+			}
+			bank.processBlock(laneOut.data(), laneIn.data(), laneCutoffs.data(), resonances.data(), n);
+			gBenchSink = laneOut[n * lanes - 1];
+		});
+	}
+}
+
+static void benchEnvelope(BenchmarkRunner& runner) {
+	for(int blockSize : runner.getBlockSizes()) {
+		for(int curve = 0; curve < kNumEnvelopeCurves; curve++) {
+			for(float time : {0.001f, 0.1f, 2.0f}) {
+				ASR env;
+				env.setSampleRate(kSampleRate);
+				env.setAttackTime(time);
+				env.setReleaseTime(time);
+				env.setSustainMode(false);
+				env.setCurve((EnvelopeCurve)curve);
+				const BenchParams params = {{"curve", curve}, {"time", time}};
+				runner.run("ASR::process", params, blockSize, [&](int n) {
+					float sum = 0.0f;
+					for(int i = 0; i < n; i++) {
+						if(!env.isActive())
+							env.trigger();
+						sum += env.process();
+					}
+					gBenchSink = sum;
+				});
+				std::vector<float> out(blockSize);
+				runner.run("ASR::processBlock", params, blockSize, [&](int n) {
+					if(!env.isActive())
+						env.trigger();
+					env.processBlock(out.data(), n);
+					gBenchSink = out[n - 1];
+				});
+			}
+		}
+	}
+}
+
+static void benchSequence(BenchmarkRunner& runner) {
+	for(int blockSize : runner.getBlockSizes()) {
+		for(int scale : {NO_SCALE, CHROMATIC}) {
+			for(int mode = VCO; mode <= SUB2; mode++) {
+				Oscillator osc(kSampleRate, SAW);
+				osc.setScale((Scale)scale);
+				Sequence seq;
+				seq.setup();
+				seq.setRange(1);
+				seq.setMode((SeqMode)mode);
+				for(int b = 0; b < 4; b++)
+					seq.setBeatOffset(b, 0.25f * b - 0.4f);
+				int counter = 0;
+				runner.run("Sequence::modulateOscillator", {{"mode", mode}, {"scale", scale}}, blockSize, [&](int n) {
+					for(int i = 0; i < n; i++) {
+						seq.modulateOscillator(500.0f, &osc);
+						if(++counter >= 4410) { // 10 steps per second
+							seq.beat();
+							counter = 0;
+						}
+					}
+				});
+				// mode and scale chosen once per block, steps land on block boundaries
+				std::vector<float> knob(blockSize, 500.0f), frames(blockSize * OscillatorBank::kNumLanes);
+				runner.run("Sequence::modulateBlock", {{"mode", mode}, {"scale", scale}}, blockSize, [&](int n) {
+					seq.modulateBlock(knob.data(), &osc, frames.data(), OscillatorBank::kNumLanes, n);
+					counter += n;
+					if(counter >= 4410) {
+						seq.beat();
+						counter = 0;
+					}
+					gBenchSink = frames[1];
+				});
+			}
+		}
+	}
+}
+
+// GUI handoff per block: nothing new, one slider moved, and every parameter moved
+static void benchParameters(BenchmarkRunner& runner) {
+	const int numParams = 36;
+	std::vector<ParameterInfo> info(numParams, {PARAM_FLOAT, 0.0f, 1.0f, 0.0f});
+	for(int blockSize : runner.getBlockSizes()) {
+		for(int changed : {0, 1, numParams}) {
+			ParameterStore store;
+			store.setup(info.data(), numParams);
+			float value = 0.0f;
+			runner.run("ParameterStore::consume", {{"changed", changed}}, blockSize, [&](int n) {
+				if(changed > 0) {
+					value = value < 1.0f ? value + 0.001f : 0.0f;
+					for(int i = 0; i < changed; i++)
+						store.set(i, value);
+					store.publish();
+				}
+				gBenchSink = store.consume() ? store.getFloat(0) : 0.0f;
+			});
+		}
+		// packet decoding on the GUI task, an unchanged packet is rejected from its header
+		for(int changed : {0, 1, numParams}) {
+			ParameterStore store;
+			store.setup(info.data(), numParams);
+			GuiProtocol protocol;
+			std::vector<float> packet(GuiProtocol::packetSize(numParams));
+			std::vector<int> ids(numParams);
+			std::vector<float> values(numParams, 0.5f);
+			for(int i = 0; i < numParams; i++)
+				ids[i] = i;
+			int version = 1;
+			GuiProtocol::encode(packet.data(), 1, version, ids.data(), values.data(), changed);
+			runner.run("GuiProtocol::decode", {{"changed", changed}}, blockSize, [&](int n) {
+				if(changed > 0)
+					GuiProtocol::encode(packet.data(), 1, ++version, ids.data(), values.data(), changed);
+				gBenchSink = protocol.decode(packet.data(), packet.size(), store);
+			});
+		}
+	}
+}
+
+// one knob at half the audio rate, moving every analog frame so the smoothers never settle
+static void benchControlInput(BenchmarkRunner& runner) {
+	for(int blockSize : runner.getBlockSizes()) {
+		for(int type = SMOOTH_NONE; type <= SMOOTH_ONE_POLE; type++) {
+			ControlInput control(0.0f, 0.8f, kMinVcoFreq, kMaxVcoFreq);
+			control.setSmoothing((Smoothing)type, kSampleRate, 0.005f);
+			std::vector<float> raw(blockSize / 2), out(blockSize);
+			float knob = 0.0f;
+			runner.run("ControlInput::processBlock", {{"smoothing", type}}, blockSize, [&](int n) {
+				for(int i = 0; i < n / 2; i++) {
+					knob = knob < 0.8f ? knob + 0.001f : 0.0f;
+					raw[i] = knob;
+				}
+				control.processBlock(out.data(), raw.data(), n / 2, 2);
+				gBenchSink = out[n - 1];
+			});
+		}
+	}
+}
+
+// the whole engine, using the same entry points the Bela core calls
+// first silent with the envelopes closed, then with the gate pressed and the envelope held open
+static void benchRender(BenchmarkRunner& runner) {
+	extern unsigned long gIdleFrames, gRenderedFrames;
+	static bool isSetup = false;
+	static bool isGated = false;
+	if(!runner.enabled("render"))
+		return;
+	for(int gated = 0; gated <= 1; gated++) {
+		for(int blockSize : runner.getBlockSizes()) {
+			std::vector<float> audioOut(blockSize * 2);
+			std::vector<float> analogIn(blockSize / 2 * 8, 0.4f);
+			std::vector<uint32_t> digital(blockSize, 0);
+			BelaContext context;
+			memset(&context, 0, sizeof(context));
+			context.audioOut = audioOut.data();
+			context.analogIn = analogIn.data();
+			context.digital = digital.data();
+			context.audioFrames = blockSize;
+			context.audioOutChannels = 2;
+			context.audioSampleRate = kSampleRate;
+			context.analogFrames = blockSize / 2;
+			context.analogInChannels = 8;
+			context.analogSampleRate = kSampleRate / 2;
+			context.digitalFrames = blockSize;
+			context.projectName = "bench";
+			if(!isSetup) {
+				// size the engine's block buffers for the largest block, smaller blocks use a prefix
+				BelaContext setupContext = context;
+				const std::vector<int>& sizes = runner.getBlockSizes();
+				setupContext.audioFrames = setupContext.digitalFrames = *std::max_element(sizes.begin(), sizes.end());
+				setupContext.analogFrames = setupContext.audioFrames / 2;
+				if(!setup(&setupContext, nullptr))
+					return;
+				// the GUI stays at the sketch.js defaults the parameter store starts with
+				isSetup = true;
+			}
+			if(gated && !isGated) {
+				// hold the gate pin for longer than the debounce interval, then let go to trigger
+				for(int pin = 1; pin >= 0; pin--) {
+					std::fill(digital.begin(), digital.end(), (uint32_t)pin << 16);
+					for(int frames = 0; frames < kSampleRate * 0.1f; frames += blockSize)
+						render(&context, nullptr);
+				}
+				isGated = true;
+			}
+			gIdleFrames = gRenderedFrames = 0;
+			BenchmarkResult *result = runner.run("render", {{"gated", gated}}, blockSize, [&](int n) {
+				render(&context, nullptr);
+				context.audioFramesElapsed += n;
+				gBenchSink = audioOut[0];
+			});
+			if(result && gRenderedFrames > 0)
+				result->metrics.push_back({"idle", gIdleFrames / (double)gRenderedFrames});
+		}
+	}
+}
+
+// Where a small impulse through one lane, with no resonance, comes out 12 dB down (four sections 3 dB down each),
+// in cents from the cutoff asked for
+static double cutoffErrorCents(FilterModel model, float cutoff) {
+	const int length = 16384;
+	const int lanes = ResFilterBank::kNumLanes;
+	const float level = 1e-3f; // keeps the tanh linear
+	std::vector<float> signal(length * lanes, 0.0f), cutoffs(length * lanes, cutoff), resonance(length, 0.0f);
+	signal[0] = level;
+	ResFilterBank bank(kSampleRate);
+	bank.setModel(model);
+	bank.processBlock(signal.data(), signal.data(), cutoffs.data(), resonance.data(), length);
+	std::vector<std::complex<double> > spectrum(length);
+	for(int i = 0; i < length; i++)
+		spectrum[i] = signal[i * lanes] / level;
+	fft(spectrum, -1);
+	const double target = 4.0 * 20.0 * log10(sqrt(0.5));
+	double previous = 0.0;
+	for(int bin = 1; bin < length / 2; bin++) {
+		double db = 20.0 * log10(std::abs(spectrum[bin]) / std::abs(spectrum[0]));
+		if(db < target) {
+			double frequency = (bin - (target - db) / (previous - db)) * kSampleRate / length;
+			return 1200.0 * log2(frequency / cutoff);
+		}
+		previous = db;
+	}
+	return 1200.0 * log2(kSampleRate / 2.0 / cutoff); // never that far down
+}
+
+// each filter model on four modulated lanes, with how far its cutoff lands from where it was asked for
+static void benchFilterModels(BenchmarkRunner& runner) {
+	const int lanes = ResFilterBank::kNumLanes;
+	for(int model = 0; model < kNumFilterModels; model++) {
+		if(!runner.enabled("ResFilterBank::processBlock"))
+			return;
+		const double errors[] = {cutoffErrorCents((FilterModel)model, 1000.0f), cutoffErrorCents((FilterModel)model, 5000.0f),
+			cutoffErrorCents((FilterModel)model, 15000.0f)};
+		for(int blockSize : runner.getBlockSizes()) {
+			std::vector<float> in(blockSize * lanes), out(blockSize * lanes), cutoffs(blockSize * lanes), resonances(blockSize, 0.8f);
+			for(int i = 0; i < blockSize * lanes; i++)
+				in[i] = ((i / lanes) % 100) / 50.0f - 1.0f;
+			ResFilterBank bank(kSampleRate);
+			bank.setModel((FilterModel)model);
+			float c = 1000.0f;
+			BenchmarkResult *result = runner.run("ResFilterBank::processBlock", {{"model", model}}, blockSize, [&](int n) {
+				for(int i = 0; i < n; i++) {
+					for(int l = 0; l < lanes; l++)
+						cutoffs[i * lanes + l] = c * (l + 1);
+					c = c < 4000.0f ? c * 1.001f : 1000.0f;
+				}
+				bank.processBlock(out.data(), in.data(), cutoffs.data(), resonances.data(), n);
+				gBenchSink = out[n * lanes - 1];
+			});
+			if(result) {
+				result->metrics.push_back({"cents_1k", errors[0]});
+				result->metrics.push_back({"cents_5k", errors[1]});
+				result->metrics.push_back({"cents_15k", errors[2]});
+			}
+		}
+	}
+}
+
+// four voices through their filters the way render.cpp runs them, mono and in stereo, where each voice fills two
+// neighbouring lanes with its panned sides and the four voices take two banks
+static void benchStereo(BenchmarkRunner& runner) {
+	const std::string name = "Voice::processOscillators+ResFilterBank";
+	if(!runner.enabled(name))
+		return;
+	const int lanes = ResFilterBank::kNumLanes;
+	const int voices = 4;
+	for(int sides = 1; sides <= 2; sides++) {
+		const int banks = voices * sides / lanes;
+		for(int blockSize : runner.getBlockSizes()) {
+			std::vector<float> frequencies(blockSize * OscillatorBank::kNumLanes), gains(blockSize * OscillatorBank::kNumLanes, 0.3f);
+			for(int i = 0; i < blockSize; i++) {
+				for(int vco = 0; vco < OscillatorBank::kNumVcos; vco++) {
+					frequencies[i * OscillatorBank::kNumLanes + OscillatorBank::lane(vco, 0)] = 110.0f * (vco + 2);
+					frequencies[i * OscillatorBank::kNumLanes + OscillatorBank::lane(vco, 1)] = 2;
+					frequencies[i * OscillatorBank::kNumLanes + OscillatorBank::lane(vco, 2)] = 3;
+				}
+			}
+			std::vector<float> left(blockSize), right(blockSize), resonances(blockSize, 0.5f);
+			std::vector<float> filterIn(banks * blockSize * lanes), cutoffs(banks * blockSize * lanes);
+			for(int i = 0; i < banks * blockSize * lanes; i++)
+				cutoffs[i] = 1000.0f * (1 + (i % lanes));
+			Voice voiceSet[voices];
+			ResFilterBank filters[2];
+			for(int v = 0; v < voices; v++)
+				voiceSet[v].setup(kSampleRate);
+			for(int b = 0; b < banks; b++)
+				filters[b].setup(kSampleRate);
+			runner.run(name, {{"sides", sides}}, blockSize, [&](int n) {
+				for(int v = 0; v < voices; v++) {
+					if(sides == 2)
+						voiceSet[v].processOscillators(left.data(), right.data(), frequencies.data(), gains.data(), n);
+					else
+						voiceSet[v].processOscillators(left.data(), frequencies.data(), gains.data(), n);
+					for(int side = 0; side < sides; side++) {
+						const float *voiceOut = side ? right.data() : left.data();
+						int lane = v * sides + side;
+						float *in = &filterIn[(lane / lanes) * blockSize * lanes + lane % lanes];
+						for(int i = 0; i < n; i++)
+							in[i * lanes] = voiceOut[i];
+					}
+				}
+				for(int b = 0; b < banks; b++) {
+					float *in = &filterIn[b * blockSize * lanes];
+					filters[b].processBlock(in, in, &cutoffs[b * blockSize * lanes], resonances.data(), n);
+				}
+				gBenchSink = filterIn[n * lanes - 1];
+			});
+		}
+	}
+}
+
+// the lane kernels at every SIMD level this CPU has, they compute the same samples so only the cost differs
+static void benchSimdLevels(BenchmarkRunner& runner) {
+	const SimdLevel selected = getSimdLevel();
+	const int lanes = ResFilterBank::kNumLanes;
+	for(int level = 0; level < kNumSimdLevels; level++) {
+		if(!setSimdLevel((SimdLevel)level))
+			continue;
+		for(int blockSize : runner.getBlockSizes()) {
+			std::vector<float> out1(blockSize), out2(blockSize);
+			for(int wave = SAW; wave <= SQUARE; wave++) {
+				OscillatorBank bank(kSampleRate);
+				bank.setAntiAlias(DPW2);
+				for(int vco = 0; vco < OscillatorBank::kNumVcos; vco++) {
+					bank.setWaveType(vco, (WaveType)wave);
+					bank.setFrequencies(vco, 440.0f, 2, 3);
+					bank.setGains(vco, 0.8f, 0.2f, 0.2f);
+				}
+				runner.run("OscillatorBank::processBlock", {{"simd", level}, {"wave", wave}}, blockSize, [&](int n) {
+					bank.processBlock(out1.data(), out2.data(), n);
+					gBenchSink = out1[n - 1] + out2[n - 1];
+				});
+			}
+
+			std::vector<float> in(blockSize * lanes), out(blockSize * lanes), cutoffs(blockSize * lanes), resonances(blockSize, 0.5f);
+			for(int i = 0; i < blockSize * lanes; i++) {
+				in[i] = ((i / lanes) % 100) / 50.0f - 1.0f;
+				cutoffs[i] = 1000.0f * (i % lanes + 1);
+			}
+			ResFilterBank filter(kSampleRate);
+			runner.run("ResFilterBank::processBlock", {{"simd", level}}, blockSize, [&](int n) {
+				filter.processBlock(out.data(), in.data(), cutoffs.data(), resonances.data(), n);
+				gBenchSink = out[n * lanes - 1];
+			});
+
+			std::vector<float> over(blockSize * kMaxOversampling * lanes);
+			Oversampler up, down;
+			up.setup(kMaxOversampling);
+			down.setup(kMaxOversampling);
+			runner.run("Oversampler::upsample", {{"factor", kMaxOversampling}, {"simd", level}}, blockSize, [&](int n) {
+				up.upsample(over.data(), in.data(), n);
+				gBenchSink = over[0];
+			});
+			runner.run("Oversampler::downsample", {{"factor", kMaxOversampling}, {"simd", level}}, blockSize, [&](int n) {
+				down.downsample(out.data(), over.data(), n);
+				gBenchSink = out[0];
+			});
+		}
+	}
+	setSimdLevel(selected);
+}
+
+void runDspBenchmarks(BenchmarkRunner& runner) {
+	benchOscillatorCores(runner);
+	benchOscillator(runner);
+	benchOscillatorBank(runner);
+	benchFilters(runner);
+	benchFilterModels(runner);
+	benchSimdLevels(runner);
+	benchStereo(runner);
+	benchEnvelope(runner);
+	benchSequence(runner);
+	benchControlInput(runner);
+	benchParameters(runner);
+	benchRender(runner);
+}
+
+#endif // HOST_BUILD
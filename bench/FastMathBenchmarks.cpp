@@ -0,0 +1,185 @@
+/* FastMathBenchmarks.cpp: cost and accuracy of the FastMath.h approximations, next to the libm functions they replace
+ * Each FastMath:: case sweeps its function's whole range against double precision libm and reports the worst error
+ * with the bound documented in FastMath.h. A case outside its bound is reported on stderr and fails the run
+ */
+#ifdef HOST_BUILD
+
+#include "Benchmark.h"
+#include "../FastMath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static const int kSweepPoints = 1 << 20;
+
+static bool gFastMathPassed = true;
+
+struct FastMathCase {
+	float low, high; // input range, swept linearly, or log2 of the range if logarithmic
+	bool logarithmic;
+};
+
+static const FastMathCase kExp2 = {-126.0f, 126.0f, false};
+static const FastMathCase kLog2 = {-126.0f, 127.99f, true}; // every normal binade
+static const FastMathCase kPow = {-10.0f, 10.0f, true}; // bases from 2^-10 to 2^10
+static const FastMathCase kTanh = {-20.0f, 20.0f, false};
+static const float kPowExponents[] = {-3.7f, -1.0f, -0.5f, 0.3333333f, 2.2f, 4.0f};
+
+static float sweepPoint(const FastMathCase& c, int i) {
+	float x = c.low + (c.high - c.low) * (float)i / (float)(kSweepPoints - 1);
+	return c.logarithmic ? (float)exp2((double)x) : x;
+}
+
+// runs fn on a whole number of V at a time, V being a Simd.h backend
+template<typename V, typename Fn>
+static void applyLanes(float *out, const float *in, int count, Fn fn) {
+	for(int i = 0; i + V::kWidth <= count; i += V::kWidth)
+		V::store(out + i, fn(V::load(in + i)));
+}
+
+struct FastMathError {
+	double relative = 0.0;
+	double absolute = 0.0;
+};
+
+// worst error of fn over the case's range against reference, pow scaled by 1 + |y log2 x| as in FastMath.h
+template<typename V, typename Fn, typename Ref>
+static FastMathError measureError(const FastMathCase& c, Fn fn, Ref reference, double powScale) {
+	const int chunk = 1024;
+	float in[chunk], out[chunk];
+	FastMathError error;
+	for(int start = 0; start < kSweepPoints; start += chunk) {
+		for(int i = 0; i < chunk; i++)
+			in[i] = sweepPoint(c, start + i);
+		applyLanes<V>(out, in, chunk, fn);
+		for(int i = 0; i < chunk; i++) {
+			double expected = reference((double)in[i]);
+			double scale = (powScale != 0.0) ? 1.0 + fabs(powScale * log2((double)in[i])) : 1.0;
+			double diff = fabs((double)out[i] - expected);
+			error.absolute = std::max(error.absolute, diff / scale);
+			if(expected != 0.0)
+				error.relative = std::max(error.relative, diff / fabs(expected) / scale);
+		}
+	}
+	return error;
+}
+
+static void report(BenchmarkResult *result, const char *metric, double error, double bound) {
+	if(!result)
+		return;
+	bool within = error <= bound;
+	result->metrics.push_back({metric, error});
+	result->metrics.push_back({"bound", bound});
+	result->metrics.push_back({"within_bound", within ? 1.0 : 0.0});
+	if(!within) {
+		fprintf(stderr, "FAIL: %s %s %g exceeds the documented %g\n", result->name.c_str(), metric, error, bound);
+		gFastMathPassed = false;
+	}
+}
+
+// one backend, told apart by its lanes: cycles per value of each function, with its worst error
+template<typename V>
+static void benchBackend(BenchmarkRunner& runner) {
+	const std::string prefix = "FastMath::";
+	for(int blockSize : runner.getBlockSizes()) {
+		std::vector<float> in(blockSize), out(blockSize);
+		const BenchParams params = {{"lanes", (double)V::kWidth}};
+
+		if(runner.enabled(prefix + "exp2")) {
+			for(int i = 0; i < blockSize; i++)
+				in[i] = sweepPoint(kExp2, i * (kSweepPoints / blockSize));
+			auto fn = [](V x) { return fastExp2(x); };
+			BenchmarkResult *result = runner.run(prefix + "exp2", params, blockSize, [&](int n) {
+				applyLanes<V>(out.data(), in.data(), n, fn);
+				gBenchSink = out[n - 1];
+			});
+			report(result, "max_rel_err", measureError<V>(kExp2, fn, [](double x) { return exp2(x); }, 0.0).relative, 2.5e-7);
+		}
+		if(runner.enabled(prefix + "log2")) {
+			for(int i = 0; i < blockSize; i++)
+				in[i] = sweepPoint(kLog2, i * (kSweepPoints / blockSize));
+			auto fn = [](V x) { return fastLog2(x); };
+			BenchmarkResult *result = runner.run(prefix + "log2", params, blockSize, [&](int n) {
+				applyLanes<V>(out.data(), in.data(), n, fn);
+				gBenchSink = out[n - 1];
+			});
+			report(result, "max_abs_err", measureError<V>(kLog2, fn, [](double x) { return log2(x); }, 0.0).absolute, 2.5e-7);
+		}
+		if(runner.enabled(prefix + "pow")) {
+			for(int i = 0; i < blockSize; i++)
+				in[i] = sweepPoint(kPow, i * (kSweepPoints / blockSize));
+			auto timed = [](V x) { return fastPow(x, V::splat(2.2f)); };
+			BenchmarkResult *result = runner.run(prefix + "pow", params, blockSize, [&](int n) {
+				applyLanes<V>(out.data(), in.data(), n, timed);
+				gBenchSink = out[n - 1];
+			});
+			double worst = 0.0;
+			for(float y : kPowExponents) {
+				auto fn = [y](V x) { return fastPow(x, V::splat(y)); };
+				double e = measureError<V>(kPow, fn, [y](double x) { return pow(x, (double)y); }, y).relative;
+				worst = std::max(worst, e);
+			}
+			report(result, "max_rel_err", worst, 2.5e-7);
+		}
+		if(runner.enabled(prefix + "tanh")) {
+			for(int i = 0; i < blockSize; i++)
+				in[i] = sweepPoint(kTanh, i * (kSweepPoints / blockSize));
+			auto fn = [](V x) { return fastTanh(x); };
+			BenchmarkResult *result = runner.run(prefix + "tanh", params, blockSize, [&](int n) {
+				applyLanes<V>(out.data(), in.data(), n, fn);
+				gBenchSink = out[n - 1];
+			});
+			FastMathError error = measureError<V>(kTanh, fn, [](double x) { return tanh(x); }, 0.0);
+			report(result, "max_abs_err", error.absolute, 2.5e-7);
+			report(result, "max_rel_err", error.relative, 3e-7);
+		}
+	}
+}
+
+// the libm functions the audio path used before, per value
+static void benchLibm(BenchmarkRunner& runner) {
+	for(int blockSize : runner.getBlockSizes()) {
+		std::vector<float> in(blockSize), out(blockSize);
+		for(int i = 0; i < blockSize; i++)
+			in[i] = sweepPoint(kExp2, i * (kSweepPoints / blockSize));
+		runner.run("libm::exp2f", {}, blockSize, [&](int n) {
+			for(int i = 0; i < n; i++)
+				out[i] = exp2f(in[i]);
+			gBenchSink = out[n - 1];
+		});
+		for(int i = 0; i < blockSize; i++)
+			in[i] = sweepPoint(kLog2, i * (kSweepPoints / blockSize));
+		runner.run("libm::log2f", {}, blockSize, [&](int n) {
+			for(int i = 0; i < n; i++)
+				out[i] = log2f(in[i]);
+			gBenchSink = out[n - 1];
+		});
+		for(int i = 0; i < blockSize; i++)
+			in[i] = sweepPoint(kPow, i * (kSweepPoints / blockSize));
+		runner.run("libm::powf", {}, blockSize, [&](int n) {
+			for(int i = 0; i < n; i++)
+				out[i] = powf(in[i], 2.2f);
+			gBenchSink = out[n - 1];
+		});
+		for(int i = 0; i < blockSize; i++)
+			in[i] = sweepPoint(kTanh, i * (kSweepPoints / blockSize));
+		runner.run("libm::tanhf", {}, blockSize, [&](int n) {
+			for(int i = 0; i < n; i++)
+				out[i] = tanhf(in[i]);
+			gBenchSink = out[n - 1];
+		});
+	}
+}
+
+bool runFastMathBenchmarks(BenchmarkRunner& runner) {
+	benchBackend<SimdScalar>(runner);
+	if(SimdBaseline::kWidth > 1)
+		benchBackend<SimdBaseline>(runner);
+#if defined(__AVX2__)
+	benchBackend<SimdAvx2>(runner); // with -mavx2, the kernels are not built for AVX2 otherwise
+#endif
+	benchLibm(runner);
+	return gFastMathPassed;
+}
+
+#endif // HOST_BUILD
@@ -0,0 +1,143 @@
+/* OversampleBenchmarks.cpp: cost of running the voices oversampled, per factor and stage
+ * Oversample::voices runs four voices and their filter bank the way render.cpp does, so its cycles per sample are
+ * what each setting costs the audio thread. As metrics it reports the aliasing of one sawtooth driven through a
+ * resonant filter and the rejection of the halfband filters
+ */
+#ifdef HOST_BUILD
+
+#include "Benchmark.h"
+#include "../Oversampler.h"
+#include "../ResFilterBank.h"
+#include "../Voice.h"
+#include <algorithm>
+
+static const float kSampleRate = 44100.0f;
+static const int kAnalysisLength = 32768;
+static const int kSettleSamples = 4096;
+static const int kMaxBlock = 128;
+static const int kLanes = ResFilterBank::kNumLanes;
+
+// the oscillator, filter and conversion stages of render.cpp for one bank of voices, with fixed controls
+class VoiceChain {
+public:
+	VoiceChain(int factor, int stages, float frequency, float cutoff, float resonance)
+		: oscFactor_((stages & OVERSAMPLE_OSCILLATORS) ? factor : 1), filterFactor_((stages & OVERSAMPLE_FILTER) ? factor : 1),
+		frequencies_(kMaxBlock * OscillatorBank::kNumLanes), gains_(kMaxBlock * OscillatorBank::kNumLanes, 0.0f),
+		voiceOut_(kMaxBlock * kMaxOversampling), filterIn_(kMaxBlock * kMaxOversampling * kLanes),
+		upsampled_(kMaxBlock * kMaxOversampling * kLanes), cutoffs_(kMaxBlock * kMaxOversampling * kLanes, cutoff),
+		resonance_(kMaxBlock * kMaxOversampling, resonance) {
+		for(int v = 0; v < kLanes; v++)
+			voices_[v].setup(kSampleRate, oscFactor_);
+		filter_.setup(kSampleRate * filterFactor_);
+		upsampler_.setup(filterFactor_);
+		decimator_.setup(std::max(oscFactor_, filterFactor_));
+		for(int n = 0; n < kMaxBlock; n++) {
+			float *f = &frequencies_[n * OscillatorBank::kNumLanes];
+			for(int vco = 0; vco < OscillatorBank::kNumVcos; vco++) {
+				f[OscillatorBank::lane(vco, 0)] = frequency;
+				f[OscillatorBank::lane(vco, 1)] = 2;
+				f[OscillatorBank::lane(vco, 2)] = 3;
+			}
+			gains_[n * OscillatorBank::kNumLanes] = 1.0f; // only the first VCO sounds, so its harmonics are known
+		}
+	}
+
+	// numFrames audio rate frames of every voice, interleaved
+	const float* process(int numFrames) {
+		for(int v = 0; v < kLanes; v++) {
+			voices_[v].processOscillators(voiceOut_.data(), frequencies_.data(), gains_.data(), numFrames);
+			for(int n = 0; n < numFrames * oscFactor_; n++)
+				filterIn_[n * kLanes + v] = voiceOut_[n];
+		}
+		float *in = filterIn_.data();
+		if(oscFactor_ > filterFactor_)
+			decimator_.downsample(in, in, numFrames);
+		else if(oscFactor_ < filterFactor_) {
+			upsampler_.upsample(upsampled_.data(), in, numFrames);
+			in = upsampled_.data();
+		}
+		filter_.processBlock(in, in, cutoffs_.data(), resonance_.data(), numFrames * filterFactor_);
+		if(filterFactor_ > 1)
+			decimator_.downsample(filterIn_.data(), in, numFrames);
+		return filterIn_.data();
+	}
+
+	double stopbandDb() const { return decimator_.stopbandDb(); }
+
+private:
+	int oscFactor_;
+	int filterFactor_;
+	Voice voices_[kLanes];
+	ResFilterBank filter_;
+	Oversampler upsampler_;
+	Oversampler decimator_;
+	std::vector<float> frequencies_, gains_, voiceOut_, filterIn_, upsampled_, cutoffs_, resonance_;
+};
+
+static void benchVoices(BenchmarkRunner& runner) {
+	const std::string name = "Oversample::voices";
+	if(!runner.enabled(name))
+		return;
+	const float frequency = 2500.0f;
+	for(int factor = 1; factor <= kMaxOversampling; factor *= 2) {
+		for(int stages = OVERSAMPLE_OSCILLATORS; stages <= (OVERSAMPLE_OSCILLATORS | OVERSAMPLE_FILTER); stages++) {
+			if(factor == 1 && stages != OVERSAMPLE_OSCILLATORS)
+				continue; // nothing to tell apart
+			// the first voice through a bright, resonant filter, loud enough to drive its nonlinearity
+			VoiceChain chain(factor, stages, frequency, 18000.0f, 0.5f);
+			std::vector<float> signal(kAnalysisLength);
+			for(int n = 0; n < kSettleSamples; n += kMaxBlock)
+				chain.process(kMaxBlock);
+			for(int n = 0; n < kAnalysisLength; n += kMaxBlock) {
+				const float *out = chain.process(kMaxBlock);
+				for(int i = 0; i < kMaxBlock; i++)
+					signal[n + i] = out[i * kLanes];
+			}
+			AliasMeasurement aliasing = measureAliasing(signal, frequency);
+
+			for(int blockSize : runner.getBlockSizes()) {
+				if(blockSize > kMaxBlock)
+					continue;
+				BenchmarkResult *result = runner.run(name, {{"factor", factor}, {"stages", stages}}, blockSize, [&](int n) {
+					gBenchSink = chain.process(n)[0];
+				});
+				if(result) {
+					result->metrics.push_back({"alias_db", aliasing.aliasDb});
+					result->metrics.push_back({"audible_db", aliasing.audibleDb});
+					result->metrics.push_back({"stopband_db", chain.stopbandDb()});
+				}
+			}
+		}
+	}
+}
+
+// the converters alone, cycles per audio rate frame of four lanes
+static void benchConverters(BenchmarkRunner& runner) {
+	for(int factor = 2; factor <= kMaxOversampling; factor *= 2) {
+		Oversampler up, down;
+		up.setup(factor);
+		down.setup(factor);
+		for(int blockSize : runner.getBlockSizes()) {
+			std::vector<float> in(blockSize * kLanes, 0.5f), over(blockSize * factor * kLanes), out(blockSize * kLanes);
+			BenchmarkResult *result = runner.run("Oversampler::upsample", {{"factor", factor}}, blockSize, [&](int n) {
+				up.upsample(over.data(), in.data(), n);
+				gBenchSink = over[0];
+			});
+			if(result)
+				result->metrics.push_back({"stopband_db", up.stopbandDb()});
+			result = runner.run("Oversampler::downsample", {{"factor", factor}}, blockSize, [&](int n) {
+				down.downsample(out.data(), over.data(), n);
+				gBenchSink = out[0];
+			});
+			if(result)
+				result->metrics.push_back({"stopband_db", down.stopbandDb()});
+		}
+	}
+}
+
+void runOversampleBenchmarks(BenchmarkRunner& runner) {
+	benchConverters(runner);
+	benchVoices(runner);
+}
+
+#endif // HOST_BUILD
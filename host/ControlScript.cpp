@@ -0,0 +1,74 @@
+/* ControlScript.cpp: parses control scripts for the host renderer
+ */
+#ifdef HOST_BUILD
+
+#include "ControlScript.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+bool ControlScript::load(const std::string& path) {
+	std::ifstream file(path);
+	if(!file) {
+		fprintf(stderr, "Error: cannot open control script %s\n", path.c_str());
+		return false;
+	}
+	events_.clear();
+	std::string line;
+	int lineNumber = 0;
+	while(std::getline(file, line)) {
+		if(!parseLine(line, ++lineNumber))
+			return false;
+	}
+	// keep file order for events at the same time
+	std::stable_sort(events_.begin(), events_.end(), [](const ControlEvent& a, const ControlEvent& b) {
+		return a.time < b.time;
+	});
+	return true;
+}
+
+bool ControlScript::parseLine(const std::string& line, int lineNumber) {
+	std::istringstream in(line.substr(0, line.find('#')));
+	ControlEvent event;
+	std::string kind;
+	if(!(in >> event.time)) {
+		return true; // blank or comment line
+	}
+	if(!(in >> kind)) {
+		fprintf(stderr, "Error: line %d: missing event kind\n", lineNumber);
+		return false;
+	}
+	event.index = 0;
+	event.value = 0.0f;
+	if(kind == "end") {
+		event.kind = CONTROL_END;
+	}
+	else {
+		if(kind == "analog") event.kind = CONTROL_ANALOG;
+		else if(kind == "digital") event.kind = CONTROL_DIGITAL;
+		else if(kind == "gui") event.kind = CONTROL_GUI;
+		else {
+			fprintf(stderr, "Error: line %d: unknown event kind '%s'\n", lineNumber, kind.c_str());
+			return false;
+		}
+		if(!(in >> event.index >> event.value)) {
+			fprintf(stderr, "Error: line %d: expected <index> <value>\n", lineNumber);
+			return false;
+		}
+	}
+	events_.push_back(event);
+	return true;
+}
+
+double ControlScript::getEndTime() {
+	double last = 0.0;
+	for(const ControlEvent& event : events_) {
+		if(event.kind == CONTROL_END)
+			return event.time;
+		last = std::max(last, event.time);
+	}
+	return last + 1.0;
+}
+
+#endif // HOST_BUILD
@@ -0,0 +1,42 @@
+/* ControlScript.h: timed control events (knobs, buttons, GUI values) for the host renderer
+ *
+ * One event per line, '#' starts a comment:
+ *   <seconds> analog <channel> <value>   raw analogRead() value, 0 to 1
+ *   <seconds> digital <pin> <0|1>        button pin level
+ *   <seconds> gui <index> <value>        float in GUI buffer 0, offsets as in sketch.js
+ *   <seconds> end                        stop rendering at this time
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+enum ControlKind {
+	CONTROL_ANALOG = 0,
+	CONTROL_DIGITAL = 1,
+	CONTROL_GUI = 2,
+	CONTROL_END = 3
+};
+
+struct ControlEvent {
+	double time; // seconds from start of render
+	ControlKind kind;
+	int index;
+	float value;
+};
+
+class ControlScript {
+public:
+	ControlScript() {} // Default constructor
+
+	bool load(const std::string& path); // parse a script file, events are sorted by time
+	bool parseLine(const std::string& line, int lineNumber); // parse and append one line
+
+	const std::vector<ControlEvent>& getEvents() { return events_; }
+	double getEndTime(); // time of the end event, or one second past the last event
+
+	~ControlScript() {} // Destructor
+
+private:
+	std::vector<ControlEvent> events_;
+};
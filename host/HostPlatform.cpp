@@ -0,0 +1,48 @@
+/* HostPlatform.cpp: implements the host stand-ins for the Bela GUI and auxiliary tasks
+ */
+#ifdef HOST_BUILD
+
+#include "HostPlatform.h"
+#include "../AllocationGuard.h"
+
+int Gui::setBuffer(char bufferType, unsigned int size) {
+	buffers_.push_back(DataBuffer(bufferType, size));
+	return buffers_.size() - 1;
+}
+
+int Gui::sendBuffer(unsigned int bufferId, const float *values, unsigned int count) {
+	if(bufferId >= sent_.size())
+		sent_.resize(bufferId + 1);
+	sent_[bufferId].assign(values, values + count);
+	return 0;
+}
+
+const std::vector<float>& Gui::getLastSent(unsigned int bufferId) {
+	static const std::vector<float> kNothing;
+	return bufferId < sent_.size() ? sent_[bufferId] : kNothing;
+}
+
+namespace {
+struct HostAuxiliaryTask {
+	void (*callback)(void*);
+	void *arg;
+};
+}
+
+AuxiliaryTask Bela_createAuxiliaryTask(void (*callback)(void*), int priority, const char *name, void *arg) {
+	HostAuxiliaryTask *task = new HostAuxiliaryTask; // lives as long as the program, like on Bela
+	task->callback = callback;
+	task->arg = arg;
+	return task;
+}
+
+int Bela_scheduleAuxiliaryTask(AuxiliaryTask task) {
+	HostAuxiliaryTask *t = (HostAuxiliaryTask*)task;
+#ifdef ALLOCATION_GUARD
+	AllocationGuard::Pause pause; // would run on its own thread on Bela
+#endif
+	t->callback(t->arg);
+	return 0;
+}
+
+#endif // HOST_BUILD
@@ -0,0 +1,126 @@
+/* HostPlatform.h: stand-ins for the parts of the Bela API used by render.cpp
+ * The host driver fills the context buffers from a control script and calls render() offline
+ */
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define rt_printf printf
+
+// pin directions, only kept for API compatibility
+#define INPUT 0
+#define OUTPUT 1
+
+// subset of BelaContext, buffers are interleaved like the Bela defaults
+struct BelaContext {
+	float *audioOut;
+	float *analogIn;
+	uint32_t *digital; // low 16 bits direction, high 16 bits pin values
+
+	uint32_t audioFrames;
+	uint32_t audioOutChannels;
+	float audioSampleRate;
+
+	uint32_t analogFrames;
+	uint32_t analogInChannels;
+	float analogSampleRate;
+
+	uint32_t digitalFrames;
+	uint32_t digitalChannels;
+
+	uint64_t audioFramesElapsed;
+	const char *projectName;
+};
+
+static inline float analogRead(BelaContext *context, int frame, int channel)
+{
+	return context->analogIn[frame * context->analogInChannels + channel];
+}
+
+static inline void audioWrite(BelaContext *context, int frame, int channel, float value)
+{
+	context->audioOut[frame * context->audioOutChannels + channel] = value;
+}
+
+static inline int digitalRead(BelaContext *context, int frame, int channel)
+{
+	return (context->digital[frame] >> (channel + 16)) & 1;
+}
+
+static inline void pinMode(BelaContext *context, int frame, int channel, int mode)
+{
+	// all host pins are inputs driven by the control script
+}
+
+static inline float map(float x, float in_min, float in_max, float out_min, float out_max)
+{
+	return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+static inline float constrain(float x, float min_val, float max_val)
+{
+	if(x < min_val) return min_val;
+	if(x > max_val) return max_val;
+	return x;
+}
+
+// GUI data buffer, values are written by the host driver instead of the browser
+class DataBuffer {
+public:
+	DataBuffer(char type, unsigned int size) : type_(type), data_(size, 0.0f) {}
+
+	float* getAsFloat() { return data_.data(); }
+	unsigned int getNumElements() { return data_.size(); }
+	char getType() { return type_; }
+
+private:
+	char type_;
+	std::vector<float> data_;
+};
+
+class Gui {
+public:
+	Gui() {}
+
+	int setup(std::string projectName) { return 0; }
+
+	// returns the index of the new buffer
+	int setBuffer(char bufferType, unsigned int size);
+	DataBuffer& getDataBuffer(unsigned int bufferId) { return buffers_[bufferId]; }
+	unsigned int getNumBuffers() { return buffers_.size(); }
+
+	// values sent to the browser, the host driver reads back the last ones on each buffer
+	int sendBuffer(unsigned int bufferId, float value) { return sendBuffer(bufferId, &value, 1); }
+	template<typename T, size_t N>
+	int sendBuffer(unsigned int bufferId, T (&buffer)[N]) { return sendBuffer(bufferId, buffer, N); }
+	const std::vector<float>& getLastSent(unsigned int bufferId);
+
+private:
+	int sendBuffer(unsigned int bufferId, const float *values, unsigned int count);
+	
+	std::vector<DataBuffer> buffers_;
+	std::vector<std::vector<float> > sent_;
+};
+
+// auxiliary tasks run straight away on the calling thread, so offline renders stay deterministic
+typedef void* AuxiliaryTask;
+AuxiliaryTask Bela_createAuxiliaryTask(void (*callback)(void*), int priority, const char *name, void *arg = NULL);
+int Bela_scheduleAuxiliaryTask(AuxiliaryTask task);
+
+// oscilloscope logging is dropped on the host
+class Scope {
+public:
+	Scope() {}
+
+	void setup(unsigned int numChannels, float sampleRate) {}
+	void log(float value) {}
+};
+
+// entry points implemented by render.cpp
+bool setup(BelaContext *context, void *userData);
+void render(BelaContext *context, void *userData);
+void cleanup(BelaContext *context, void *userData);
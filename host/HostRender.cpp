@@ -0,0 +1,339 @@
+// HostRender.cpp: offline host driver, runs the Bela setup()/render()/cleanup() from a
+// control script and writes the output to a WAV file as fast as the CPU allows
+//
+// Build from the project root:
+//   g++ -std=c++11 -O3 -DHOST_BUILD -I. *.cpp host/*.cpp -o subharmonicon-render
+#ifdef HOST_BUILD
+
+#include "HostPlatform.h"
+#include "ControlScript.h"
+#include "WavWriter.h"
+#include "../GuiProtocol.h"
+#include "../ParameterStore.h"
+#include "../AllocationGuard.h"
+#include "../AntiAlias.h"
+#include "../Wavetable.h"
+#include "../Oversampler.h"
+#include "../ResFilterBank.h"
+#include "../Simd.h"
+#include "../Voice.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <unistd.h>
+
+// defined in render.cpp, the GUI parameter defaults match the initial buffer in sketch.js
+extern Gui gGui;
+extern const ParameterInfo kGuiParams[];
+extern const int kNumGuiParams;
+
+static void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [options] <control-script> <output.wav>\n"
+		"  -r <rate>      audio sample rate (44100)\n"
+		"  -p <frames>    audio frames per block (32)\n"
+		"  -C <channels>  analog channels, 8 runs analog at half the audio rate (8)\n"
+		"  -o <channels>  audio output channels (2)\n"
+		"  -d <seconds>   render length, overrides the script end time\n"
+		"  -q <method>    oscillator anti-aliasing: dpw2, dpw3, dpw4, polyblep, minblep or wavetable\n"
+		"                 (build default)\n"
+		"  -W <file>      after setup, save the oscillator wavetables for render.cpp to map\n"
+		"  -x <factor>    oversampling: 1, 2 or 4 (build default)\n"
+		"  -X <stages>    stages run oversampled: osc, filter or both (build default)\n"
+		"  -F <model>     filter: ladder or zdf (build default)\n"
+		"  -e <curve>     envelope segments: linear or exponential (build default)\n"
+		"  -S             stereo: VCO1 left and VCO2 right, through a ladder each (build default)\n"
+		"  -w <width>     stereo width, 0 centres both VCOs and 1 pans them hard (build default)\n"
+		"  -c <octaves>   stereo cutoff offset, the right ladder this much above the left (build default)\n"
+		"  -s <level>     SIMD kernels: scalar, neon, sse2 or avx2 (best the CPU supports)\n"
+		"  -a             with -DALLOCATION_GUARD, log allocations in render() instead of aborting\n",
+		name);
+}
+
+#ifdef ALLOCATION_GUARD
+// make sure the guard is live before trusting a count of zero: an allocation and a free inside a scope
+// must both be caught, and one made while paused must not be
+static bool checkAllocationGuard() {
+	AllocationGuardMode mode = AllocationGuard::getMode();
+	AllocationGuard::setMode(GUARD_COUNT);
+	long before = AllocationGuard::getCount();
+	long caught, paused;
+	{
+		AllocationGuard::Scope scope;
+		void *volatile block = malloc(16); // volatile so the pair is not optimised away
+		free(block);
+		caught = AllocationGuard::getCount() - before;
+		{
+			AllocationGuard::Pause pause;
+			block = malloc(16);
+			free(block);
+		}
+		paused = AllocationGuard::getCount() - before - caught;
+	}
+	AllocationGuard::setMode(mode);
+	return caught == 2 && paused == 0;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+	float sampleRate = 44100.0f;
+	int blockSize = 32;
+	int analogChannels = 8;
+	int outChannels = 2;
+	double duration = -1.0;
+	const char *wavetablePath = nullptr;
+	int oversampleFactor = getOversampleFactor();
+	int oversampleStages = getOversampleStages();
+	bool stereo = getStereoOutput();
+	float stereoWidth = getStereoWidth();
+	float stereoCutoffOffset = getStereoCutoffOffset();
+
+	int opt;
+	while((opt = getopt(argc, argv, "r:p:C:o:d:q:W:x:X:F:e:Sw:c:s:ah")) != -1) {
+		switch(opt) {
+			case 'r': sampleRate = atof(optarg); break;
+			case 'p': blockSize = atoi(optarg); break;
+			case 'C': analogChannels = atoi(optarg); break;
+			case 'o': outChannels = atoi(optarg); break;
+			case 'd': duration = atof(optarg); break;
+			case 'W': wavetablePath = optarg; break;
+			case 'x': oversampleFactor = atoi(optarg); break;
+			case 'X':
+				if(strcmp(optarg, "osc") == 0)
+					oversampleStages = OVERSAMPLE_OSCILLATORS;
+				else if(strcmp(optarg, "filter") == 0)
+					oversampleStages = OVERSAMPLE_FILTER;
+				else if(strcmp(optarg, "both") == 0)
+					oversampleStages = OVERSAMPLE_OSCILLATORS | OVERSAMPLE_FILTER;
+				else {
+					fprintf(stderr, "Error: unknown oversampling stages '%s'\n", optarg);
+					return 1;
+				}
+				break;
+			case 'F': {
+				FilterModel model;
+				if(!parseFilterModel(optarg, &model)) {
+					fprintf(stderr, "Error: unknown filter model '%s'\n", optarg);
+					return 1;
+				}
+				setDefaultFilterModel(model); // read by the filter banks in setup()
+				break;
+			}
+			case 'e': {
+				EnvelopeCurve curve;
+				if(!parseEnvelopeCurve(optarg, &curve)) {
+					fprintf(stderr, "Error: unknown envelope curve '%s'\n", optarg);
+					return 1;
+				}
+				setDefaultEnvelopeCurve(curve); // read by the voices in setup()
+				break;
+			}
+			case 'S': stereo = true; break;
+			case 'w': stereoWidth = atof(optarg); break;
+			case 'c': stereoCutoffOffset = atof(optarg); break;
+			case 's': {
+				SimdLevel level;
+				if(!parseSimdLevel(optarg, &level)) {
+					fprintf(stderr, "Error: unknown SIMD level '%s'\n", optarg);
+					return 1;
+				}
+				if(!setSimdLevel(level)) {
+					fprintf(stderr, "Error: %s kernels are not supported here\n", optarg);
+					return 1;
+				}
+				break;
+			}
+			case 'q': {
+				AntiAlias method;
+				if(!parseAntiAlias(optarg, &method)) {
+					fprintf(stderr, "Error: unknown anti-aliasing method '%s'\n", optarg);
+					return 1;
+				}
+				setDefaultAntiAlias(method); // read by the voices in setup()
+				break;
+			}
+#ifdef ALLOCATION_GUARD
+			case 'a': AllocationGuard::setMode(GUARD_LOG); break;
+#else
+			case 'a': break;
+#endif
+			default: usage(argv[0]); return 1;
+		}
+	}
+	if(argc - optind != 2 || blockSize <= 0 || outChannels <= 0 || analogChannels <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+#ifdef ALLOCATION_GUARD
+	if(!checkAllocationGuard()) {
+		fprintf(stderr, "Error: the allocation guard did not catch a test allocation\n");
+		return 1;
+	}
+	long guardBaseline = AllocationGuard::getCount();
+#endif
+	if(!setOversampling(oversampleFactor, oversampleStages)) { // read by setup()
+		fprintf(stderr, "Error: oversampling factor must be 1, 2 or 4\n");
+		return 1;
+	}
+	if(!setStereoOutput(stereo, stereoWidth, stereoCutoffOffset)) { // read by setup()
+		fprintf(stderr, "Error: stereo width must be from 0 to 1\n");
+		return 1;
+	}
+
+	ControlScript script;
+	if(!script.load(argv[optind]))
+		return 1;
+	if(duration < 0.0)
+		duration = script.getEndTime();
+
+	// Bela halves the analog rate when all 8 channels are enabled
+	int audioFramesPerAnalogFrame = analogChannels > 4 ? 2 : 1;
+	if(blockSize % audioFramesPerAnalogFrame != 0) {
+		fprintf(stderr, "Error: block size must be a multiple of %d\n", audioFramesPerAnalogFrame);
+		return 1;
+	}
+
+	std::vector<float> audioOut(blockSize * outChannels);
+	std::vector<float> analogIn(blockSize / audioFramesPerAnalogFrame * analogChannels);
+	std::vector<uint32_t> digital(blockSize);
+
+	BelaContext context;
+	memset(&context, 0, sizeof(context));
+	context.audioOut = audioOut.data();
+	context.analogIn = analogIn.data();
+	context.digital = digital.data();
+	context.audioFrames = blockSize;
+	context.audioOutChannels = outChannels;
+	context.audioSampleRate = sampleRate;
+	context.analogFrames = blockSize / audioFramesPerAnalogFrame;
+	context.analogInChannels = analogChannels;
+	context.analogSampleRate = sampleRate / audioFramesPerAnalogFrame;
+	context.digitalFrames = blockSize;
+	context.digitalChannels = 16;
+	context.projectName = "digital-subharmonicon";
+
+	if(!setup(&context, nullptr)) {
+		fprintf(stderr, "Error: setup() failed\n");
+		return 1;
+	}
+	if(wavetablePath && !Wavetables::shared().save(wavetablePath)) {
+		fprintf(stderr, "Error: can not write %s\n", wavetablePath);
+		return 1;
+	}
+
+	// the driver plays the part of sketch.js: it holds the GUI values and, before each block, sends
+	// every change the synth has not acknowledged yet. Nothing is acknowledged at first, so the
+	// first packet carries the whole page like a freshly loaded browser
+	const int numGuiParams = kNumGuiParams;
+	std::vector<float> guiValues(numGuiParams);
+	for(int i = 0; i < numGuiParams; i++) {
+		guiValues[i] = kGuiParams[i].defaultValue;
+	}
+	std::vector<float> guiAcked(numGuiParams, NAN);
+	std::map<int, std::vector<float> > guiInFlight; // values sent in each unacknowledged version
+	std::vector<int> changedIds(numGuiParams);
+	std::vector<float> changedValues(numGuiParams);
+	std::vector<float> lastPacket;
+	int guiVersion = 0;
+	const int guiClient = 1; // the only page
+	if(gGui.getNumBuffers() == 0 || (int)gGui.getDataBuffer(0).getNumElements() < GuiProtocol::packetSize(numGuiParams)) {
+		fprintf(stderr, "Error: setup() did not create the GUI packet buffer\n");
+		return 1;
+	}
+	DataBuffer& guiBuffer = gGui.getDataBuffer(0);
+
+	WavWriter wav;
+	if(!wav.open(argv[optind + 1], outChannels, (int)sampleRate)) {
+		fprintf(stderr, "Error: cannot open %s for writing\n", argv[optind + 1]);
+		return 1;
+	}
+
+	// current control values, updated as script events are reached
+	std::vector<float> analogState(analogChannels, 0.0f);
+	uint32_t pinState = 0;
+
+	const std::vector<ControlEvent>& events = script.getEvents();
+	unsigned int nextEvent = 0;
+	uint64_t totalFrames = (uint64_t)(duration * sampleRate);
+	uint64_t numBlocks = (totalFrames + blockSize - 1) / blockSize;
+
+	auto start = std::chrono::steady_clock::now();
+	for(uint64_t block = 0; block < numBlocks; block++) {
+		for(int n = 0; n < blockSize; n++) {
+			// apply every event due at or before this frame
+			double now = (context.audioFramesElapsed + n) / (double)sampleRate;
+			while(nextEvent < events.size() && events[nextEvent].time <= now) {
+				const ControlEvent& event = events[nextEvent++];
+				if(event.kind == CONTROL_ANALOG && event.index >= 0 && event.index < analogChannels)
+					analogState[event.index] = event.value;
+				else if(event.kind == CONTROL_DIGITAL && event.index >= 0 && event.index < 16) {
+					if(event.value != 0.0f) pinState |= (1u << event.index);
+					else pinState &= ~(1u << event.index);
+				}
+				else if(event.kind == CONTROL_GUI && event.index >= 0 && event.index < numGuiParams)
+					guiValues[event.index] = event.value;
+			}
+			digital[n] = pinState << 16;
+			if(n % audioFramesPerAnalogFrame == 0) {
+				for(int ch = 0; ch < analogChannels; ch++)
+					analogIn[(n / audioFramesPerAnalogFrame) * analogChannels + ch] = analogState[ch];
+			}
+		}
+
+		// take in the latest acknowledgement, then send what is still outstanding if it changed
+		const std::vector<float>& ack = gGui.getLastSent(0);
+		int acked = ((int)ack.size() >= GuiProtocol::kAckSize && ack[0] == guiClient) ? (int)ack[1] : 0;
+		std::map<int, std::vector<float> >::iterator ackedPacket = guiInFlight.find(acked);
+		if(ackedPacket != guiInFlight.end()) {
+			for(int i = 0; i < numGuiParams; i++) {
+				if(!std::isnan(ackedPacket->second[i]))
+					guiAcked[i] = ackedPacket->second[i];
+			}
+			guiInFlight.erase(guiInFlight.begin(), ++ackedPacket);
+		}
+		int numChanged = 0;
+		for(int i = 0; i < numGuiParams; i++) {
+			if(guiValues[i] != guiAcked[i]) {
+				changedIds[numChanged] = i;
+				changedValues[numChanged++] = guiValues[i];
+			}
+		}
+		std::vector<float> packet(changedValues.begin(), changedValues.begin() + numChanged);
+		packet.insert(packet.end(), changedIds.begin(), changedIds.begin() + numChanged);
+		if(numChanged > 0 && packet != lastPacket) {
+			guiVersion = guiVersion % (GuiProtocol::kMaxVersion - 1) + 1;
+			GuiProtocol::encode(guiBuffer.getAsFloat(), guiClient, guiVersion, changedIds.data(), changedValues.data(), numChanged);
+			std::vector<float>& sent = guiInFlight[guiVersion];
+			sent.assign(numGuiParams, NAN);
+			for(int i = 0; i < numChanged; i++)
+				sent[changedIds[i]] = changedValues[i];
+			lastPacket.swap(packet);
+		}
+
+		render(&context, nullptr);
+
+		uint64_t framesLeft = totalFrames - context.audioFramesElapsed;
+		wav.write(audioOut.data(), framesLeft < (uint64_t)blockSize ? (int)framesLeft : blockSize);
+		context.audioFramesElapsed += blockSize;
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	cleanup(&context, nullptr);
+	wav.close();
+
+	fprintf(stderr, "Rendered %.2f s of audio in %.3f s (%.1fx realtime)\n",
+		duration, elapsed, elapsed > 0.0 ? duration / elapsed : 0.0);
+#ifdef ALLOCATION_GUARD
+	long allocations = AllocationGuard::getCount() - guardBaseline;
+	if(allocations > 0) {
+		fprintf(stderr, "Error: %ld allocations in render()\n", allocations);
+		return 1;
+	}
+	fprintf(stderr, "Allocation guard: no allocations in render()\n");
+#endif
+	return 0;
+}
+
+#endif // HOST_BUILD
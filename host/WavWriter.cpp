@@ -0,0 +1,63 @@
+/* WavWriter.cpp: implements the float WAV writer used by the host renderer
+ */
+#ifdef HOST_BUILD
+
+#include "WavWriter.h"
+
+static void writeU32(FILE *f, uint32_t v) {
+	uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+	fwrite(b, 1, 4, f);
+}
+
+static void writeU16(FILE *f, uint16_t v) {
+	uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+	fwrite(b, 1, 2, f);
+}
+
+bool WavWriter::open(const std::string& path, int numChannels, int sampleRate) {
+	close();
+	file_ = fopen(path.c_str(), "wb");
+	if(file_ == nullptr)
+		return false;
+	numChannels_ = numChannels;
+	sampleRate_ = sampleRate;
+	framesWritten_ = 0;
+	writeHeader(); // sizes are patched in close()
+	return true;
+}
+
+void WavWriter::writeHeader() {
+	uint32_t dataBytes = framesWritten_ * numChannels_ * sizeof(float);
+	fwrite("RIFF", 1, 4, file_);
+	writeU32(file_, 36 + dataBytes);
+	fwrite("WAVE", 1, 4, file_);
+	fwrite("fmt ", 1, 4, file_);
+	writeU32(file_, 16);
+	writeU16(file_, 3); // IEEE float
+	writeU16(file_, numChannels_);
+	writeU32(file_, sampleRate_);
+	writeU32(file_, sampleRate_ * numChannels_ * sizeof(float));
+	writeU16(file_, numChannels_ * sizeof(float));
+	writeU16(file_, 32);
+	fwrite("data", 1, 4, file_);
+	writeU32(file_, dataBytes);
+}
+
+void WavWriter::write(const float *interleaved, int numFrames) {
+	if(file_ == nullptr)
+		return;
+	// WAV is little endian, as are both x86 and the Bela's ARM core
+	fwrite(interleaved, sizeof(float), numFrames * numChannels_, file_);
+	framesWritten_ += numFrames;
+}
+
+void WavWriter::close() {
+	if(file_ == nullptr)
+		return;
+	fseek(file_, 0, SEEK_SET);
+	writeHeader();
+	fclose(file_);
+	file_ = nullptr;
+}
+
+#endif // HOST_BUILD
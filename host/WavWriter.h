@@ -0,0 +1,26 @@
+/* WavWriter.h: minimal writer for interleaved 32-bit float WAV files
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+class WavWriter {
+public:
+	WavWriter() {} // Default constructor
+
+	bool open(const std::string& path, int numChannels, int sampleRate); // write placeholder header
+	void write(const float *interleaved, int numFrames); // append frames
+	void close(); // patch chunk sizes and close the file
+
+	~WavWriter() { close(); } // Destructor
+
+private:
+	FILE *file_ = nullptr;
+	int numChannels_ = 0;
+	int sampleRate_ = 0;
+	uint32_t framesWritten_ = 0;
+
+	void writeHeader();
+};
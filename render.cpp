@@ -5,14 +5,25 @@
 // Final Project: Moog Subharmonicon Replica
 // Sara Adkins
 
-#include <Bela.h>
-#include <libraries/Gui/Gui.h>
-#include <libraries/Scope/Scope.h>
+#include "Platform.h"
+#include <algorithm>
+#include <cmath>
 #include "Oscillator.h"
-#include "ResFilter.h"
+#include "OscillatorBank.h"
+#include "PitchQuantizer.h"
+#include "Wavetable.h"
+#include "ResFilterBank.h"
+#include "Oversampler.h"
 #include "Debouncer.h"
-#include "ASR.h"
+#include "Voice.h"
+#include "VoiceAllocator.h"
+#include "ControlInput.h"
+#include "Metronome.h"
+#include "ParameterStore.h"
+#include "GuiProtocol.h"
 #include "Sequence.h"
+#include "CpuProfiler.h"
+#include "AllocationGuard.h"
 
 // Browser-based GUI to adjust parameters
 Gui gGui;
@@ -20,9 +31,27 @@ Gui gGui;
 // Browser-based oscilloscope to visualise signal
 Scope gScope;
 
-// Two oscillators with shared 4th order Moog filter
-Oscillator gOsc1, gOsc2;
-ResFilter filter;
+// Voices of two oscillators with a 4th order Moog filter and envelopes, so earlier notes can
+// ring out while a new one starts. The filters of four voices run together, one per vector lane. In stereo
+// mode each voice has a filter per side, in neighbouring lanes, so both of a voice's ladders share a register
+const int kNumVoices = 4;
+const int kMaxSides = 2;
+const int kNumFilterBanks = (kNumVoices * kMaxSides + ResFilterBank::kNumLanes - 1) / ResFilterBank::kNumLanes;
+unsigned int gNumSides = 1;
+unsigned int gNumFilterBanks = 1; // banks in use, the voices' lanes fill them in order
+float gSideCutoffScale[kMaxSides] = {1.0f, 1.0f}; // half the stereo cutoff offset down on the left, up on the right
+VoiceAllocator gVoices;
+ResFilterBank gFilterBanks[kNumFilterBanks];
+
+// The oscillators and filters can each run at 2x or 4x the audio rate (see Oversampler.h), the filter input is
+// converted between their rates and the filter output brought back to the audio rate
+int gOscFactor = 1;
+int gFilterFactor = 1;
+Oversampler gFilterUpsamplers[kNumFilterBanks]; // oscillator rate to filter rate, when only the filter is oversampled
+Oversampler gFilterDecimators[kNumFilterBanks]; // whichever stage runs last at the oversampled rate back to audio
+
+//every per-block buffer holds the largest block Bela runs, so render() works in storage fixed at compile time
+const unsigned int kMaxBlockSize = 128;
 
 // Each oscillator can be modulated by a sequence
 Sequence seq1, seq2;
@@ -37,6 +66,7 @@ const int kTempoChannel = 4;
 const int kOsc2FreqChannel = 5;
 const int kOsc1AmpChannel = 6;
 const int kOsc2AmpChannel = 7;
+const int kNumAnalogChannels = 8;
 const int kGatePin = 0;
 const int kPlayPin = 1;
 
@@ -52,9 +82,14 @@ const float kMaxEg = 10000.0f;
 const float kMinTempo = 0.333f;
 const float kMaxTempo = 300.0f; // altered this from moog 3000
 
+//analog controls, read and scaled once per analog frame then smoothed to audio rate
+const float kKnobSmoothingTime = 0.005f; // one-pole time constant for pitch and cutoff knobs
+ControlInput gControls[kNumAnalogChannels];
+float gAnalogFrames[kNumAnalogChannels][kMaxBlockSize]; // raw analog values for one block
+float gControlValues[kNumAnalogChannels][kMaxBlockSize]; // audio rate parameter values for one block
+
 
 Debouncer gDebouncerGate, gDebouncerPlay; //button debouncer
-ASR gAmplitudeASR, gFilterASR; //envelopes for amplitude and filter cutoff
 
 //synthesizer play states
 enum PlayState {
@@ -64,14 +99,27 @@ enum PlayState {
 };
 PlayState state_ = OFF;
 
+//skip the oscillators of voices whose amplitude envelope is closed, and the filters as well when
+//every voice is. A voice's oscillators pause and pick up where they left off on its next trigger
+const bool kSkipWhenIdle = true;
+bool gFiltersIdle = false; //the filters were skipped and reset, and stay clear until a voice plays again
+unsigned long gIdleFrames = 0, gRenderedFrames = 0; //for reporting the idle ratio
+
 //keep track of base tempo
-int gMetroPeriod;
-int gMetroCounter = 0;
+Metronome gMetronome;
+
+//button presses found while debouncing a block
+struct ButtonEvent {
+	unsigned int frame;
+	bool gatePressed;
+	bool playPressed;
+};
+ButtonEvent gButtonEvents[kMaxBlockSize];
 
 //keep track of rhythms, always a multiple of base tempo
-std::vector<int> gRhythmDivs;
-std::vector<int> gRhythmCounters;
 const int kNumRhythms = 4;
+int gRhythmDivs[kNumRhythms];
+int gRhythmCounters[kNumRhythms];
 
 //which sequence a rhythm should trigger
 enum RhythmTarget {
@@ -80,7 +128,7 @@ enum RhythmTarget {
 	SEQ2 = 2,
 	BOTH = 3
 };
-std::vector<RhythmTarget> gRhythmTargets;
+RhythmTarget gRhythmTargets[kNumRhythms];
 
 //buffer offsets for parameters received from GUI
 const int osc1Offset = 0; //3
@@ -95,28 +143,143 @@ const int seqModeOffset = 25; //2
 const int seqRangeOffset = 27; //1
 const int rhythmTargetsOffset = 28; //4
 const int rhythmDivsOffset = 32; //4
-const int kNumGuiParams = 36;
+extern const int kNumGuiParams = 36;
+
+//type, range and default of each GUI parameter, defaults match the buffer in sketch.js. Not local to this
+//file, the host driver starts its copy of the page from the defaults
+extern const ParameterInfo kGuiParams[kNumGuiParams] = {
+	{PARAM_INT, 0, USER_WAVE, 0}, {PARAM_INT, 1, 16, 2}, {PARAM_INT, 1, 16, 3}, // osc 1 wave type and sub ratios
+	{PARAM_INT, 0, USER_WAVE, 0}, {PARAM_INT, 1, 16, 2}, {PARAM_INT, 1, 16, 3}, // osc 2 wave type and sub ratios
+	{PARAM_FLOAT, 0, 1, 0.2}, {PARAM_FLOAT, 0, 1, 0.2}, {PARAM_FLOAT, 0, 1, 0.0}, {PARAM_FLOAT, 0, 1, 0.0}, // sub levels
+	{PARAM_INT, 0, kNumScales - 1, 0}, // scale
+	{PARAM_FLOAT, 0, 1, 0.1}, {PARAM_FLOAT, 0, 1, 0.1}, {PARAM_FLOAT, 0, 1, 0.1}, {PARAM_FLOAT, 0, 1, 0.1}, {PARAM_FLOAT, 0, 1, 0}, // envelopes
+	{PARAM_FLOAT, -1, 1, 0}, // EG amount
+	{PARAM_FLOAT, -1, 1, 0}, {PARAM_FLOAT, -1, 1, 0}, {PARAM_FLOAT, -1, 1, 0}, {PARAM_FLOAT, -1, 1, 0}, // sequence 1 steps
+	{PARAM_FLOAT, -1, 1, 0}, {PARAM_FLOAT, -1, 1, 0}, {PARAM_FLOAT, -1, 1, 0}, {PARAM_FLOAT, -1, 1, 0}, // sequence 2 steps
+	{PARAM_INT, 0, 2, 0}, {PARAM_INT, 0, 2, 0}, // sequence modes
+	{PARAM_INT, 0, 2, 0}, // sequence range
+	{PARAM_INT, 0, 3, 1}, {PARAM_INT, 0, 3, 0}, {PARAM_INT, 0, 3, 0}, {PARAM_INT, 0, 3, 0}, // rhythm targets
+	{PARAM_INT, 1, 16, 1}, {PARAM_INT, 1, 16, 1}, {PARAM_INT, 1, 16, 1}, {PARAM_INT, 1, 16, 1} // rhythm divisions
+};
+
+//GUI packets are decoded on an auxiliary task and handed to render() as snapshots
+ParameterStore gParams;
+GuiProtocol gGuiProtocol;
+AuxiliaryTask gGuiTask;
+const float kGuiPollInterval = 0.01f; // seconds between checks for a new packet
+int gGuiPollBlocks;
+int gGuiPollCounter;
+
+#ifdef CPU_PROFILE
+//time spent in each stage of render(), aggregated on an auxiliary task, shown in the GUI about once a
+//second and written to a file by cleanup()
+CpuProfiler gProfiler;
+AuxiliaryTask gProfilerTask;
+const float kProfilerInterval = 0.1f; // seconds between collections, well inside the ring size
+const char *kProfileReportPath = "cpu-profile.json";
+int gProfilerBlocks;
+int gProfilerCounter = 0;
+#endif
+
+//per-block buffers, filled by the control loop and then run through each stage a block at a time
+float gOscFrequencies[kNumVoices][kMaxBlockSize * OscillatorBank::kNumLanes];
+float gOscGains[kNumVoices][kMaxBlockSize * OscillatorBank::kNumLanes];
+float gAmplitudes[kNumVoices][kMaxBlockSize];
+float gFilterEnvelope[kNumVoices][kMaxBlockSize];
+unsigned int gVoiceStart[kNumVoices]; // first frame each voice is rendered from, audioFrames if silent
+float gVoiceOut[kMaxSides][kMaxBlockSize * kMaxOversampling]; // oscillator mix of one voice per side, at the oscillator rate
+float gCutoffStart[kMaxBlockSize], gCutoffRamp[kMaxBlockSize]; // filter envelope range from the cutoff and EG controls
+float gFilterIn[kNumFilterBanks][kMaxBlockSize * kMaxOversampling * ResFilterBank::kNumLanes]; // filtered in place
+float gFilterUpsampled[kNumFilterBanks][kMaxBlockSize * kMaxOversampling * ResFilterBank::kNumLanes];
+float gFilterCutoffs[kNumFilterBanks][kMaxBlockSize * kMaxOversampling * ResFilterBank::kNumLanes]; // at the filter rate
+float gFilterResonance[kMaxBlockSize * kMaxOversampling];
+
+//filter lane of side of voice v, counted across the banks
+inline unsigned int filterLane(unsigned int v, unsigned int side)
+{
+	return v * gNumSides + side;
+}
+
+//auxiliary task: apply a new packet of GUI changes to the parameter store and acknowledge it to the page that sent it
+void readGuiParameters(void*)
+{
+	DataBuffer& buffer = gGui.getDataBuffer(0);
+	if(gGuiProtocol.decode(buffer.getAsFloat(), buffer.getNumElements(), gParams)) {
+		float ack[GuiProtocol::kAckSize];
+		gGuiProtocol.getAck(ack);
+		gGui.sendBuffer(0, ack);
+	}
+}
+
+#ifdef CPU_PROFILE
+//auxiliary task: fold the latest blocks into the CPU histograms and send a report when a window is full
+void collectProfile(void*)
+{
+	if(gProfiler.collect()) {
+		float report[CpuProfiler::kReportSize];
+		gProfiler.getReport(report);
+		gGui.sendBuffer(1, report);
+		gProfiler.startWindow();
+	}
+}
+#endif
 
 bool setup(BelaContext *context, void *userData)
 {
+#ifdef ALLOCATION_GUARD
+	AllocationGuard::setup();
+#endif
+	
 	//Ensure analog channels are enabled
 	if(context->analogFrames == 0 ) {
 		rt_printf("Error: this example needs analog enabled\n");
 		return false;
 	}
+	if(context->audioFrames > kMaxBlockSize) {
+		rt_printf("Error: blocks of more than %d frames are not supported\n", kMaxBlockSize);
+		return false;
+	}
 	gAudioFramesPerAnalogFrame = context->audioFrames / context->analogFrames;
 		
-	//setup oscillators and their sequences
-	gOsc1.setup(context->audioSampleRate, SAW);
-	gOsc2.setup(context->audioSampleRate, SAW);
-	//rt_printf("INIT BOTH OSC\n");
-	filter.setup(context->audioSampleRate, 4);
+	//oscillator tables before the voices that read them: mapped when prebuilt, else the user wave from its file
+	Wavetables& wavetables = Wavetables::shared();
+	if(!wavetables.map("wavetables.bin"))
+		wavetables.loadSingleCycle(USER_WAVE, "wave.txt");
+	
+	//setup voices and the sequences that modulate them
+	gOscFactor = (getOversampleStages() & OVERSAMPLE_OSCILLATORS) ? getOversampleFactor() : 1;
+	gFilterFactor = (getOversampleStages() & OVERSAMPLE_FILTER) ? getOversampleFactor() : 1;
+	gVoices.setup(context->audioSampleRate, kNumVoices, gOscFactor);
+	gNumSides = getStereoOutput() ? 2 : 1;
+	gNumFilterBanks = (kNumVoices * gNumSides + ResFilterBank::kNumLanes - 1) / ResFilterBank::kNumLanes;
+	float cutoffOffset = (gNumSides == 2) ? getStereoCutoffOffset() : 0.0f;
+	gSideCutoffScale[0] = powf(2.0f, -0.5f * cutoffOffset);
+	gSideCutoffScale[1] = powf(2.0f, 0.5f * cutoffOffset);
+	//optional user scale for the quantizer, stays chromatic if there is no file
+	PitchQuantizer::shared().loadScala(USER_SCALE, "scale.scl");
+	for(unsigned int i = 0; i < gNumFilterBanks; i++) {
+		gFilterBanks[i].setup(context->audioSampleRate * gFilterFactor);
+		gFilterUpsamplers[i].setup(gFilterFactor);
+		gFilterDecimators[i].setup(std::max(gOscFactor, gFilterFactor));
+	}
 	seq1.setup();
 	seq2.setup();
 
 	// Set up the GUI
 	gGui.setup(context->projectName);
-	gGui.setBuffer('f', kNumGuiParams);
+	gGui.setBuffer('f', GuiProtocol::packetSize(kNumGuiParams));
+	gParams.setup(kGuiParams, kNumGuiParams);
+	if((gGuiTask = Bela_createAuxiliaryTask(readGuiParameters, 50, "subharmonicon-gui")) == 0)
+		return false;
+	gGuiPollBlocks = std::max(1, (int)(kGuiPollInterval * context->audioSampleRate / context->audioFrames));
+	gGuiPollCounter = gGuiPollBlocks; // copy on the first block
+	
+#ifdef CPU_PROFILE
+	gProfiler.setup(context->audioSampleRate, context->audioFrames);
+	if((gProfilerTask = Bela_createAuxiliaryTask(collectProfile, 10, "subharmonicon-profiler")) == 0)
+		return false;
+	gProfilerBlocks = std::max(1, (int)(kProfilerInterval * context->audioSampleRate / context->audioFrames));
+#endif
 	
 	//setup digital input to read buttons with a debounce of 50ms
 	pinMode(context, 0, kGatePin, INPUT); //set input
@@ -124,19 +287,13 @@ bool setup(BelaContext *context, void *userData)
 	pinMode(context, 0, kPlayPin, INPUT);
 	gDebouncerPlay.setup(context->audioSampleRate, .05);
 	
-	//setup envelopes
-	gAmplitudeASR.setSampleRate(context->audioSampleRate);
-	gFilterASR.setSampleRate(context->audioSampleRate);
-	
 	//initialize base tempo to 60BPM
-	gMetroPeriod = (int)context->audioSampleRate * 1.0f;
-	gMetroCounter = gMetroPeriod; // so we respond immediately on play
+	gMetronome.setup(context->audioSampleRate);
+	gMetronome.setTempo(1.0f);
+	gMetronome.reset(); // so we respond immediately on play
 
 	//initialze all rhythms as matching base tempo
 	//turn on rhythm1 to trigger sequence 1 as default state
-	gRhythmDivs.resize(kNumRhythms);
-	gRhythmCounters.resize(kNumRhythms);
-	gRhythmTargets.resize(kNumRhythms);
 	for(unsigned int i = 0; i < kNumRhythms; i++) {
 		gRhythmDivs[i] = 1;
 		gRhythmCounters[i] = 0.0f;
@@ -144,6 +301,23 @@ bool setup(BelaContext *context, void *userData)
 	}
 	gRhythmTargets[0] = SEQ1;
 	
+	//scale each analog input to its parameter range, smoothing the ones that would zipper
+	gControls[kOsc1FreqChannel].setup(0, 3.3/4.096, kMinVcoFreq, kMaxVcoFreq);
+	gControls[kOsc2FreqChannel].setup(0, 3.3/4.096, kMinVcoFreq, kMaxVcoFreq);
+	gControls[kCutoffChannel].setup(0, 3.34/4.096, kMinCutoffFreq, kMaxCutoffFreq);
+	gControls[kResChannel].setup(0, 3.34/4.096, 0.0, 1.0);
+	gControls[kVolumeChannel].setup(0, 3.34/4.096, 0.0f, 1.0f);
+	gControls[kTempoChannel].setup(0, 3.3/4.096, kMinTempo, kMaxTempo);
+	gControls[kOsc1AmpChannel].setup(0, 3.34/4.096, 0.0f, 1.0f);
+	gControls[kOsc2AmpChannel].setup(0, 3.34/4.096, 0.0f, 1.0f);
+	gControls[kOsc1FreqChannel].setSmoothing(SMOOTH_ONE_POLE, context->audioSampleRate, kKnobSmoothingTime);
+	gControls[kOsc2FreqChannel].setSmoothing(SMOOTH_ONE_POLE, context->audioSampleRate, kKnobSmoothingTime);
+	gControls[kCutoffChannel].setSmoothing(SMOOTH_ONE_POLE, context->audioSampleRate, kKnobSmoothingTime);
+	gControls[kResChannel].setSmoothing(SMOOTH_LINEAR, context->audioSampleRate);
+	gControls[kVolumeChannel].setSmoothing(SMOOTH_LINEAR, context->audioSampleRate);
+	gControls[kOsc1AmpChannel].setSmoothing(SMOOTH_LINEAR, context->audioSampleRate);
+	gControls[kOsc2AmpChannel].setSmoothing(SMOOTH_LINEAR, context->audioSampleRate);
+	
 	// Set up the scope
 	gScope.setup(1, context->audioSampleRate);
 
@@ -151,20 +325,17 @@ bool setup(BelaContext *context, void *userData)
 }
 
 //read envelope parameters from GUI buffer once per audio block
-void setEnvelopeParams(float *data)
+void setEnvelopeParams(const float *data)
 {
 	float ampAtk = map(data[0], 0.0, 1.0, kMinAttack, kMaxAttack);
 	float ampDec = map(data[1], 0.0, 1.0, kMinDecay, kMaxDecay);
 	float freqAtk = map(data[2], 0.0, 1.0, kMinAttack, kMaxAttack);
 	float freqDec = map(data[3], 0.0, 1.0, kMinDecay, kMaxDecay);
-	gAmplitudeASR.setAttackTime(ampAtk);
-	gAmplitudeASR.setReleaseTime(ampDec);
-	gFilterASR.setAttackTime(freqAtk);
-	gFilterASR.setReleaseTime(freqDec);
+	gVoices.setEnvelopeTimes(ampAtk, ampDec, freqAtk, freqDec);
 }
 
 //read sequence frequency offsets from GUI buffer once per audio block
-void setSeqBeats(Sequence *seq, float *data)
+void setSeqBeats(Sequence *seq, const float *data)
 {
 	seq->setBeatOffset(0, data[0]);
 	seq->setBeatOffset(1, data[1]);
@@ -173,7 +344,7 @@ void setSeqBeats(Sequence *seq, float *data)
 }
 
 //read rhythm targets from GUI buffer once per audio block
-void setRhythmTargets(float *data)
+void setRhythmTargets(const float *data)
 {
 	gRhythmTargets[0] = (RhythmTarget)(int)data[0];
 	gRhythmTargets[1] = (RhythmTarget)(int)data[1];
@@ -182,7 +353,7 @@ void setRhythmTargets(float *data)
 }
 
 //read rhythm tempo multiples from GUI buffer once per audio block
-void setRhythmDivs(float *data)
+void setRhythmDivs(const float *data)
 {
 	gRhythmDivs[0] = data[0];
 	gRhythmDivs[1] = data[1];
@@ -191,181 +362,433 @@ void setRhythmDivs(float *data)
 }
 
 //read oscillator parameters from GUI buffer once per audio block
-void setOscParams(Oscillator *osc, float *data)
+void setOscParams(Oscillator *osc, const float *data)
 {
 	osc->setWaveType((WaveType)(int)data[0]);	
 	osc->setSub1Ratio(data[1]);
 	osc->setSub2Ratio(data[2]);
 }
 
+//store one frame of held oscillator frequency and subharmonic divisors for the bank
+void setBankFrequencies(float *frequencies, int vco, Oscillator *osc)
+{
+	frequencies[OscillatorBank::lane(vco, 0)] = osc->getFrequency();
+	frequencies[OscillatorBank::lane(vco, 1)] = osc->getSub1Divisor();
+	frequencies[OscillatorBank::lane(vco, 2)] = osc->getSub2Divisor();
+}
+
+//store one frame of oscillator levels for the bank
+void setBankGains(float *gains, int vco, float amplitude, float sub1Amp, float sub2Amp)
+{
+	gains[OscillatorBank::lane(vco, 0)] = amplitude;
+	gains[OscillatorBank::lane(vco, 1)] = sub1Amp;
+	gains[OscillatorBank::lane(vco, 2)] = sub2Amp;
+}
+
+//process any changes in play state based on button presses
+void handleButtons(bool gatePressed, bool playPressed)
+{
+	if(state_ == OFF) {
+		if(playPressed) { //start sequence button pressed
+			state_ = SEQUENCE;
+			gVoices.setSustainMode(false); // go immediately from attack to decay in sequence mode
+			seq1.reset();
+			seq2.reset();
+			gMetronome.reset(); //so sequence starts up immediately
+		}
+		else if(gatePressed){ //trigger button pressed
+			state_ = GATED;
+			gVoices.trigger();
+		}
+	}
+	else if(state_ == GATED) {
+		if(gatePressed) { //untrigger button pressed
+			state_ = OFF;
+			gVoices.release();
+		}
+	}
+	else if(state_ == SEQUENCE) {
+		if(playPressed) { //stop sequence button pressed
+			state_ = OFF;
+			gVoices.release();
+			gVoices.setSustainMode(true);
+		}
+	}
+}
+
+//advance the rhythms on each metronome tick, moving sequences and triggering envelopes
+void handleMetroTick()
+{
+	seq1.setIsActive(false); //by default sequence is inactive unless triggered by a rhythm
+	seq2.setIsActive(false);
+	for(unsigned int i = 0; i < kNumRhythms; i++) { //loop through rhythm array
+		if(gRhythmTargets[i] == SEQ1) {
+			seq1.setIsActive(true);
+			if(++(gRhythmCounters[i]) >= gRhythmDivs[i]) { //update progress towards super-beat
+				//if we're on a super-beat move sequence forward and trigger envelope
+				seq1.beat();
+				gVoices.trigger();
+				gRhythmCounters[i] = 0;
+			}
+		}
+		else if(gRhythmTargets[i] == SEQ2) {
+			seq2.setIsActive(true);
+			if(++(gRhythmCounters[i]) >= gRhythmDivs[i]) {
+				seq2.beat();
+				gVoices.trigger();
+				gRhythmCounters[i] = 0;
+			}
+		}
+		else if(gRhythmTargets[i] == BOTH) {
+			seq1.setIsActive(true);
+			seq2.setIsActive(true);
+			if(++(gRhythmCounters[i]) >= gRhythmDivs[i]) {
+				seq1.beat();
+				seq2.beat();
+				gVoices.trigger();
+				gRhythmCounters[i] = 0;
+			}
+		}
+	}
+}
+
+//true if every value in the block is zero
+bool isSilent(const float *values, unsigned int numFrames)
+{
+	for(unsigned int n = 0; n < numFrames; n++) {
+		if(values[n] != 0.0f)
+			return false;
+	}
+	return true;
+}
+
+//pass the GUI parameters that changed in the latest snapshot on to the synth
+void applyGuiParameters()
+{
+	const float *data = gParams.getValues();
+	
+	if(gParams.isDirty(osc1Offset, 3) || gParams.isDirty(osc2Offset, 3) || gParams.isDirty(scaleOffset)) {
+		Scale scale = (Scale)(int)(data[scaleOffset]);
+		for(unsigned int v = 0; v < kNumVoices; v++) {
+			Voice *voice = gVoices.getVoice(v);
+			setOscParams(voice->getOsc1(), data + osc1Offset);
+			setOscParams(voice->getOsc2(), data + osc2Offset);
+			voice->getOsc1()->setScale(scale);
+			voice->getOsc2()->setScale(scale);
+		}
+	}
+	
+	if(gParams.isDirty(envelopeParamsOffset, 4))
+		setEnvelopeParams(data + envelopeParamsOffset);
+	
+	if(gParams.isDirty(seq1BeatOffset, 4))
+		setSeqBeats(&seq1, data + seq1BeatOffset);
+	if(gParams.isDirty(seq2BeatOffset, 4))
+		setSeqBeats(&seq2, data + seq2BeatOffset);
+	if(gParams.isDirty(seqModeOffset, 2)) {
+		seq1.setMode((SeqMode)(int)(data[seqModeOffset]));
+		seq2.setMode((SeqMode)(int)(data[seqModeOffset + 1]));
+	}
+	if(gParams.isDirty(seqRangeOffset)) {
+		seq1.setRange((int)data[seqRangeOffset]);
+		seq2.setRange((int)data[seqRangeOffset]);
+	}
+	
+	if(gParams.isDirty(rhythmDivsOffset, 4))
+		setRhythmDivs(data + rhythmDivsOffset);
+	if(gParams.isDirty(rhythmTargetsOffset, 4))
+		setRhythmTargets(data + rhythmTargetsOffset);
+}
+
+//render envelopes and oscillator settings for frames [start, end), which contain no events
+void renderControlSpan(unsigned int start, unsigned int end, const float *oscFrequencies, const float *oscFrequencies2,
+	const float *oscAmplitudes, const float *osc2Amplitudes, float subOsc1Amp, float subOsc2Amp, float subOsc1Amp2, float subOsc2Amp2)
+{
+	//a sequence that is not triggered by any rhythm is muted, this can only change at an event
+	//earlier voices keep the levels they had while they were current
+	float level1 = ((state_ != SEQUENCE) || seq1.getIsActive()) ? 1.0f : 0.0f;
+	float level2 = ((state_ != SEQUENCE) || seq2.getIsActive()) ? 1.0f : 0.0f;
+	Voice *current = gVoices.getCurrent();
+	current->setLevels(level1, level2);
+	
+	for(unsigned int v = 0; v < kNumVoices; v++) {
+		Voice *voice = gVoices.getVoice(v);
+		
+		// Get the next values from the ASR envelopes
+		voice->processEnvelopes(&gAmplitudes[v][start], &gFilterEnvelope[v][start], end - start);
+		
+		//a voice is rendered from the first frame its amplitude envelope is open, while it is
+		//closed the pitch is held and picked up again on the next trigger
+		bool silent = kSkipWhenIdle && isSilent(&gAmplitudes[v][start], end - start);
+		if(silent && gVoiceStart[v] > start)
+			continue;
+		if(gVoiceStart[v] > start)
+			gVoiceStart[v] = start;
+		
+		//update oscillator frequency and volume. Subharmonics are updated accordingly
+		//only the current voice follows the knobs and sequences
+		bool follow = (voice == current) && !silent;
+		float *frequencies = gOscFrequencies[v];
+		float *gains = gOscGains[v];
+		float voiceLevel1 = voice->getLevel1();
+		float voiceLevel2 = voice->getLevel2();
+		if(follow) {
+			//the beat is fixed within a span, so the sequences write the whole span at once
+			seq1.modulateBlock(&oscFrequencies[start], voice->getOsc1(), &frequencies[start * OscillatorBank::kNumLanes + OscillatorBank::lane(0, 0)],
+				OscillatorBank::kNumLanes, end - start);
+			seq2.modulateBlock(&oscFrequencies2[start], voice->getOsc2(), &frequencies[start * OscillatorBank::kNumLanes + OscillatorBank::lane(1, 0)],
+				OscillatorBank::kNumLanes, end - start);
+		}
+		else {
+			for(unsigned int n = start; n < end; n++) {
+				setBankFrequencies(&frequencies[n * OscillatorBank::kNumLanes], 0, voice->getOsc1());
+				setBankFrequencies(&frequencies[n * OscillatorBank::kNumLanes], 1, voice->getOsc2());
+			}
+		}
+		for(unsigned int n = start; n < end; n++) {
+			setBankGains(&gains[n * OscillatorBank::kNumLanes], 0, voiceLevel1 * oscAmplitudes[n], voiceLevel1 * subOsc1Amp, voiceLevel1 * subOsc2Amp);
+			setBankGains(&gains[n * OscillatorBank::kNumLanes], 1, voiceLevel2 * osc2Amplitudes[n], voiceLevel2 * subOsc1Amp2, voiceLevel2 * subOsc2Amp2);
+		}
+	}
+}
+
 void render(BelaContext *context, void *userData)
 {
 	//rt_printf("RENDER\n");
+	ALLOCATION_GUARD_SCOPE(); // debug builds stop on any allocation from here on
 	
-	//parse GUI parameters
-	DataBuffer& buffer = gGui.getDataBuffer(0);
-	float* data = buffer.getAsFloat();
+	//ask for a fresh copy of the GUI buffer every few blocks, then apply whatever changed in the newest one
+	if(++gGuiPollCounter >= gGuiPollBlocks) {
+		gGuiPollCounter = 0;
+		Bela_scheduleAuxiliaryTask(gGuiTask);
+	}
+#ifdef CPU_PROFILE
+	if(++gProfilerCounter >= gProfilerBlocks) {
+		gProfilerCounter = 0;
+		Bela_scheduleAuxiliaryTask(gProfilerTask);
+	}
+#endif
+	PROFILE_BEGIN(gProfiler);
+	
+	if(gParams.consume())
+		applyGuiParameters();
 	
-	setOscParams(&gOsc1, data + osc1Offset);
-	setOscParams(&gOsc2, data + osc2Offset);
+	const float *data = gParams.getValues();
 	float subOsc1Amp = data[subOscOffset];
 	float subOsc2Amp = data[subOscOffset+1];
 	float subOsc1Amp2 = data[subOscOffset+2];
 	float subOsc2Amp2 = data[subOscOffset+3];
-	Scale scale = (Scale)(int)(data[scaleOffset]);
-	gOsc1.setScale(scale);
-	gOsc2.setScale(scale);
-
-	setEnvelopeParams(data + envelopeParamsOffset);
 	float eg = map(data[envelopeEgOffset], -1.0, 1.0, kMinEg, kMaxEg);
 	
-	setSeqBeats(&seq1, data + seq1BeatOffset);
-	setSeqBeats(&seq2, data + seq2BeatOffset);
-	SeqMode mode = (SeqMode)(int)(data[seqModeOffset]);
-	SeqMode mode2 = (SeqMode)(int)(data[seqModeOffset + 1]);
-	seq1.setRange((int)data[seqRangeOffset]);
-	seq2.setRange((int)data[seqRangeOffset]);
-	
-	setRhythmDivs(data + rhythmDivsOffset);
-	setRhythmTargets(data + rhythmTargetsOffset);
+	//read and scale every analog input once per analog frame, then smooth to audio rate
+	for(unsigned int ch = 0; ch < kNumAnalogChannels; ch++) {
+		for(unsigned int n = 0; n < context->analogFrames; n++) {
+			gAnalogFrames[ch][n] = analogRead(context, n, ch);
+		}
+		gControls[ch].processBlock(gControlValues[ch], gAnalogFrames[ch], context->analogFrames, gAudioFramesPerAnalogFrame);
+	}
+	const float *tempos = gControlValues[kTempoChannel];
+	const float *oscAmplitudes = gControlValues[kOsc1AmpChannel];
+	const float *osc2Amplitudes = gControlValues[kOsc2AmpChannel];
+	const float *oscFrequencies = gControlValues[kOsc1FreqChannel];
+	const float *oscFrequencies2 = gControlValues[kOsc2FreqChannel];
+	const float *cutoffs = gControlValues[kCutoffChannel];
 	
 	//rt_printf("RENDER PARAMS DONE\n");
-    for(unsigned int n = 0; n < context->audioFrames; n++) {
-		//update base tempo(corresponds to sub-beat period)
-		float periodHz = map(analogRead(context, n/gAudioFramesPerAnalogFrame, kTempoChannel), 0, 3.3/4.096, kMinTempo, kMaxTempo);
-		gMetroPeriod = (1.0f / periodHz) * context->audioSampleRate;
+	
+	//debounce the buttons every frame, keeping only the frames where one was pressed
+	int numButtonEvents = 0;
+	for(unsigned int n = 0; n < context->audioFrames; n++) {
+		gDebouncerGate.process(digitalRead(context, n, kGatePin));
+		gDebouncerPlay.process(digitalRead(context, n, kPlayPin));
+		if(gDebouncerGate.fallingEdge() || gDebouncerPlay.fallingEdge()) {
+			ButtonEvent& event = gButtonEvents[numButtonEvents++];
+			event.frame = n;
+			event.gatePressed = gDebouncerGate.fallingEdge();
+			event.playPressed = gDebouncerPlay.fallingEdge();
+		}
+	}
+	
+	PROFILE_MARK(gProfiler, STAGE_CONTROLS);
+	
+	for(unsigned int v = 0; v < kNumVoices; v++) {
+		gVoiceStart[v] = context->audioFrames;
+	}
+	
+	//split the block at button presses and metronome ticks, events fire at their exact frame
+	//and everything between them is rendered as one span
+	unsigned int n = 0;
+	int nextButtonEvent = 0;
+	while(n < context->audioFrames) {
+		if(nextButtonEvent < numButtonEvents && gButtonEvents[nextButtonEvent].frame == n) {
+			handleButtons(gButtonEvents[nextButtonEvent].gatePressed, gButtonEvents[nextButtonEvent].playPressed);
+			nextButtonEvent++;
+		}
+		if(state_ == SEQUENCE) {
+			//update base tempo(corresponds to sub-beat period)
+			gMetronome.setTempo(tempos[n]);
+			if(gMetronome.framesUntilTick() == 0) { //new beat reached in sequence
+				gMetronome.tick();
+				handleMetroTick();
+			}
+		}
 		
-		//update oscillator frequency, volume ane wave type. Subharmonics are updated accordingly
-		float oscAmplitude = map(analogRead(context, n/gAudioFramesPerAnalogFrame, kOsc1AmpChannel), 0, 3.34/4.096, 0.0f, 1.0f);
-		float osc2Amplitude = map(analogRead(context, n/gAudioFramesPerAnalogFrame, kOsc2AmpChannel), 0, 3.34/4.096, 0.0f, 1.0f);
-    	float oscFrequency = map(analogRead(context, n/gAudioFramesPerAnalogFrame, kOsc1FreqChannel), 0, 3.3/4.096, kMinVcoFreq, kMaxVcoFreq);
-    	float oscFrequency2 = map(analogRead(context, n/gAudioFramesPerAnalogFrame, kOsc2FreqChannel), 0, 3.3/4.096, kMinVcoFreq, kMaxVcoFreq);
-    	seq1.modulateOscillator(oscFrequency, mode, &gOsc1);
-    	seq2.modulateOscillator(oscFrequency2, mode2, &gOsc2);
-    	
-    	//update filter parameters
-    	float cutoff = map(analogRead(context, n/gAudioFramesPerAnalogFrame, kCutoffChannel), 0, 3.34/4.096, kMinCutoffFreq, kMaxCutoffFreq);
-    	float resonance = map(analogRead(context, n/gAudioFramesPerAnalogFrame, kResChannel), 0, 3.34/4.096, 0.0, 1.0);
-    	float volume = map(analogRead(context, n/gAudioFramesPerAnalogFrame, kVolumeChannel), 0, 3.34/4.096, 0.0f, 1.0f); //update global volume
-    	
-    	//calculate start and endpoint of cutoff envelope, clipping to valid range
-    	float start, rampAmnt;
-    	if(cutoff - eg < kMinCutoffFreq) {
-    		start = kMinCutoffFreq;
-    		rampAmnt = (cutoff - start);
-    	}
-    	else if(cutoff - eg > kMaxCutoffFreq) {
-    		start = kMaxCutoffFreq;
-    		rampAmnt = (cutoff - start);
-    	}
-    	else {
-    		start = cutoff - eg;
-    		rampAmnt = eg;
+		unsigned int end = context->audioFrames;
+		if(nextButtonEvent < numButtonEvents)
+			end = std::min(end, gButtonEvents[nextButtonEvent].frame);
+		if(state_ == SEQUENCE)
+			end = std::min(end, n + gMetronome.framesUntilTick());
+		
+		renderControlSpan(n, end, oscFrequencies, oscFrequencies2, oscAmplitudes, osc2Amplitudes, subOsc1Amp, subOsc2Amp, subOsc1Amp2, subOsc2Amp2);
+		if(state_ == SEQUENCE)
+			gMetronome.advance(end - n);
+		n = end;
+	}
+	PROFILE_MARK(gProfiler, STAGE_SEQUENCING);
+	
+	//output is scaled by the amplitude envelopes, so a block where they all stay at zero is silent
+	gRenderedFrames += context->audioFrames;
+	bool idle = true;
+	for(unsigned int v = 0; v < kNumVoices; v++) {
+		idle = idle && gVoiceStart[v] == context->audioFrames;
+	}
+	if(idle) {
+		gIdleFrames += context->audioFrames;
+		//clear whatever the filters were still ringing with, rather than have it come back on the next trigger
+		if(!gFiltersIdle) {
+			for(unsigned int i = 0; i < gNumFilterBanks; i++) {
+				gFilterBanks[i].reset();
+				gFilterUpsamplers[i].reset();
+				gFilterDecimators[i].reset();
+			}
+			gFiltersIdle = true;
+		}
+		for(unsigned int n = 0; n < context->audioFrames; n++) {
+			for(unsigned int channel = 0; channel < context->audioOutChannels; channel++) {
+				audioWrite(context, n, channel, 0.0f);
+			}
+			gScope.log(0.0f);
+		}
+		PROFILE_MARK(gProfiler, STAGE_OUTPUT);
+		PROFILE_END(gProfiler);
+		return;
+	}
+	gFiltersIdle = false;
+	
+    //render each voice's oscillators into its filter lanes, voices are silent until their start frame
+    const unsigned int oscFrames = context->audioFrames * gOscFactor;
+    for(unsigned int v = 0; v < kNumVoices; v++) {
+    	unsigned int voiceStart = gVoiceStart[v];
+    	if(voiceStart < context->audioFrames) {
+    		const float *frequencies = &gOscFrequencies[v][voiceStart * OscillatorBank::kNumLanes];
+    		const float *gains = &gOscGains[v][voiceStart * OscillatorBank::kNumLanes];
+    		if(gNumSides == 2)
+    			gVoices.getVoice(v)->processOscillators(&gVoiceOut[0][voiceStart * gOscFactor], &gVoiceOut[1][voiceStart * gOscFactor],
+    				frequencies, gains, context->audioFrames - voiceStart);
+    		else
+    			gVoices.getVoice(v)->processOscillators(&gVoiceOut[0][voiceStart * gOscFactor], frequencies, gains, context->audioFrames - voiceStart);
     	}
-    	
-    	//process any changes in play state based on button status
-    	int gateValue = digitalRead(context, n, kGatePin);
-    	gDebouncerGate.process(gateValue);
-    	int playValue = digitalRead(context, n, kPlayPin);
-    	gDebouncerPlay.process(playValue);
-    	if(state_ == OFF) {
-    		if(gDebouncerPlay.fallingEdge()) { //start sequence button pressed
-    			state_ = SEQUENCE;
-    			gAmplitudeASR.setSustainMode(false); // go immediately from attack to decay in sequence mode
-    			gFilterASR.setSustainMode(false);
-    			seq1.reset();
-    			seq2.reset();
-    			gMetroCounter = gMetroPeriod; //so sequence starts up immediately
-    		}
-    		else if(gDebouncerGate.fallingEdge()){ //trigger button pressed
-    			state_ = GATED;
-    			gAmplitudeASR.trigger();
-	    		gFilterASR.trigger();
+    	for(unsigned int side = 0; side < gNumSides; side++) {
+    		unsigned int lane = filterLane(v, side);
+    		float *filterIn = gFilterIn[lane / ResFilterBank::kNumLanes] + lane % ResFilterBank::kNumLanes;
+    		for(unsigned int n = 0; n < oscFrames; n++) {
+    			filterIn[n * ResFilterBank::kNumLanes] = n < voiceStart * gOscFactor ? 0.0f : gVoiceOut[side][n];
     		}
     	}
-    	else if(state_ == GATED) {
-    		if(gDebouncerGate.fallingEdge()) { //untrigger button pressed
-    			state_ = OFF;
-    			gAmplitudeASR.release();
-	    		gFilterASR.release();
+    }
+    PROFILE_MARK(gProfiler, STAGE_OSCILLATORS);
+	
+	//calculate start and endpoint of cutoff envelope, clipping to valid range
+	for(unsigned int n = 0; n < context->audioFrames; n++) {
+		float cutoff = cutoffs[n];
+		float start, rampAmnt;
+		if(cutoff - eg < kMinCutoffFreq) {
+			start = kMinCutoffFreq;
+			rampAmnt = (cutoff - start);
+		}
+		else if(cutoff - eg > kMaxCutoffFreq) {
+			start = kMaxCutoffFreq;
+			rampAmnt = (cutoff - start);
+		}
+		else {
+			start = cutoff - eg;
+			rampAmnt = eg;
+		}
+		gCutoffStart[n] = start;
+		gCutoffRamp[n] = rampAmnt;
+	}
+    
+    //sweep each voice's cutoff with its filter envelope, held over the samples of an oversampled frame
+    //and moved apart on the two sides in stereo
+    const unsigned int filterFrames = context->audioFrames * gFilterFactor;
+    for(unsigned int v = 0; v < kNumVoices; v++) {
+    	for(unsigned int side = 0; side < gNumSides; side++) {
+    		unsigned int lane = filterLane(v, side);
+    		float *filterCutoffs = gFilterCutoffs[lane / ResFilterBank::kNumLanes] + lane % ResFilterBank::kNumLanes;
+    		float scale = gSideCutoffScale[side];
+    		for(unsigned int n = 0; n < filterFrames; n++) {
+    			unsigned int frame = n / gFilterFactor;
+    			filterCutoffs[n * ResFilterBank::kNumLanes] = (gCutoffStart[frame] + gFilterEnvelope[v][frame] * gCutoffRamp[frame]) * scale;
     		}
     	}
-    	else if(state_ == SEQUENCE) {
-    		if(gDebouncerPlay.fallingEdge()) { //stop sequence button pressed
-    			state_ = OFF;
-    			gAmplitudeASR.release();
-    			gFilterASR.release();
-    			gAmplitudeASR.setSustainMode(true);
-    			gFilterASR.setSustainMode(true);
-    		}
-    		else if(++gMetroCounter >= gMetroPeriod) { //new beat reached in sequence
-    			seq1.setIsActive(false); //by default sequence is inactive unless triggered by a rhythm
-    			seq2.setIsActive(false);
-    			for(unsigned int i = 0; i < kNumRhythms; i++) { //loop through rhythm array
-    				if(gRhythmTargets[i] == SEQ1) {
-    					seq1.setIsActive(true);
-    					if(++(gRhythmCounters[i]) >= gRhythmDivs[i]) { //update progress towards super-beat
-    						//if we're on a super-beat move sequence forward and trigger envelope
-    						seq1.beat();
-			    			gAmplitudeASR.trigger();
-			    			gFilterASR.trigger();
-			    			gRhythmCounters[i] = 0;
-    					}
-    				}
-    				else if(gRhythmTargets[i] == SEQ2) {
-    					seq2.setIsActive(true);
-    					if(++(gRhythmCounters[i]) >= gRhythmDivs[i]) {
-			    			seq2.beat();
-			    			gAmplitudeASR.trigger();
-			    			gFilterASR.trigger();
-			    			gRhythmCounters[i] = 0;
-    					}
-    				}
-    				else if(gRhythmTargets[i] == BOTH) {
-    					seq1.setIsActive(true);
-    					seq2.setIsActive(true);
-    					if(++(gRhythmCounters[i]) >= gRhythmDivs[i]) {
-    						seq1.beat();
-			    			seq2.beat();
-			    			gAmplitudeASR.trigger();
-			    			gFilterASR.trigger();
-			    			gRhythmCounters[i] = 0;
-    					}
-    				}
-    			}
-    			gMetroCounter = 0; // reset sub-beat counter
+    }
+    const float *resonance = gControlValues[kResChannel];
+    if(gFilterFactor > 1) {
+    	for(unsigned int n = 0; n < filterFrames; n++) {
+    		gFilterResonance[n] = resonance[n / gFilterFactor];
+    	}
+    	resonance = gFilterResonance;
+    }
+    PROFILE_MARK(gProfiler, STAGE_FILTER_COEFFS);
+    
+    //apply the filters, four voices at a time, at the filter rate and then back to the audio rate
+    for(unsigned int i = 0; i < gNumFilterBanks; i++) {
+    	float *filterIn = gFilterIn[i];
+    	if(gOscFactor > gFilterFactor) {
+    		gFilterDecimators[i].downsample(filterIn, filterIn, context->audioFrames);
+    	}
+    	else if(gOscFactor < gFilterFactor) {
+    		gFilterUpsamplers[i].upsample(gFilterUpsampled[i], filterIn, context->audioFrames);
+    		filterIn = gFilterUpsampled[i];
+    	}
+    	gFilterBanks[i].processBlock(filterIn, filterIn, gFilterCutoffs[i], resonance, filterFrames);
+    	if(gFilterFactor > 1) {
+    		gFilterDecimators[i].downsample(gFilterIn[i], filterIn, context->audioFrames);
+    	}
+    }
+    PROFILE_MARK(gProfiler, STAGE_FILTER);
+    
+    const float *volumes = gControlValues[kVolumeChannel];
+    for(unsigned int n = 0; n < context->audioFrames; n++) {
+    	float out[kMaxSides] = {0.0f, 0.0f};
+    	for(unsigned int v = 0; v < kNumVoices; v++) {
+    		for(unsigned int side = 0; side < gNumSides; side++) {
+    			unsigned int lane = filterLane(v, side);
+    			out[side] += gFilterIn[lane / ResFilterBank::kNumLanes][n * ResFilterBank::kNumLanes + lane % ResFilterBank::kNumLanes] * gAmplitudes[v][n];
     		}
     	}
     	
-		// Get the next value from the ASR envelopes
-    	float amplitude = gAmplitudeASR.process();
-    	float filterRamp = gFilterASR.process();
-    	
-    	filter.updateSections(context->audioSampleRate, start + filterRamp * rampAmnt, resonance); //update resonant filter
-    	
-		// combine samples from each active oscillator and apply filter
-    	float out = 0.0f;
-    	float outOsc1 = gOsc1.process(oscAmplitude, subOsc1Amp, subOsc2Amp);
-    	float outOsc2 = gOsc2.process(osc2Amplitude, subOsc1Amp2, subOsc2Amp2);
-    	if(state_ == SEQUENCE) {
-    		if(seq1.getIsActive()) out += outOsc1;
-    		if(seq2.getIsActive()) out += outOsc2;
-    	} else {
-    		out += outOsc1;
-    		out += outOsc2;
+        // Write the output to every audio channel, in stereo the left side to even channels and the right to odd ones
+    	for(unsigned int side = 0; side < gNumSides; side++) {
+    		out[side] *= volumes[n];
     	}
-    	out = filter.process(out) * amplitude * volume;
-    	
-        // Write the output to every audio channel
     	for(unsigned int channel = 0; channel < context->audioOutChannels; channel++) {
-    		audioWrite(context, n, channel, out);
+    		audioWrite(context, n, channel, out[channel % gNumSides]);
     	}
     	
-    	gScope.log(out);
+    	gScope.log(gNumSides == 2 ? 0.5f * (out[0] + out[1]) : out[0]);
     }
+    PROFILE_MARK(gProfiler, STAGE_OUTPUT);
+    PROFILE_END(gProfiler);
 }
 
 void cleanup(BelaContext *context, void *userData)
 {
-
+	if(gRenderedFrames > 0)
+		rt_printf("Idle ratio: %.3f\n", gIdleFrames / (double)gRenderedFrames);
+#ifdef CPU_PROFILE
+	collectProfile(nullptr); // pick up the blocks since the last collection
+	if(gProfiler.writeReport(kProfileReportPath))
+		rt_printf("CPU profile written to %s\n", kProfileReportPath);
+#endif
 }
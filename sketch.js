@@ -1,4 +1,4 @@
-/* sketch.js: Javascript GUI for setting synth parameters. Passes buffer of parameters to audio application
+/* sketch.js: Javascript GUI for setting synth parameters. Sends changed parameters to audio application
  * Sara Adkins
  */
 
@@ -16,12 +16,27 @@ const seqRangeOffset = 27; //1
 const rhythmTargetsOffset = 28; //4
 const rhythmDivsOffset = 32; //4
 
-//buffer to send to Bela
+//current parameter values, indexed by the offsets above
 let buffer = [0, 2, 3, 0, 2, 3, 0.2, 0.2, 0.0, 0.0, 0, 0.1, 0.1, 0.1, 0.1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 1];
 
+//packets of changes sent to Bela, format described in GuiProtocol.h
+//every change Bela has not acknowledged goes in each packet, so a lost packet is covered by the next one
+const sendInterval = 30; // ms, edits within this window are batched into one packet
+const maxVersion = 16777216; // versions wrap before they stop being exact floats
+const clientId = Math.floor(Math.random() * (maxVersion - 1)) + 1; // tells this page's acknowledgements from other pages'
+let acked = new Array(buffer.length).fill(NaN); // values Bela has confirmed, nothing at first
+let inFlight = {}; // version -> {id: value} for packets not acknowledged yet
+let version = 0;
+let lastSendTime = -sendInterval;
+
+//CPU report from the profiler, only sent when render.cpp is built with CPU_PROFILE (see CpuProfiler.h)
+const cpuStageNames = ['BLOCK', 'CONTROLS', 'SEQUENCING', 'OSCILLATORS', 'FILTER COEFFS', 'FILTER', 'OUTPUT'];
+let cpuReport;
+
 var wave_types = {
 	'SAW': 0,
-	'SQUARE': 1
+	'SQUARE': 1,
+	'USER': 2
 };
 
 var scale_types = {
@@ -29,7 +44,8 @@ var scale_types = {
 	'CHROM': 1,
 	'MAJ': 2,
 	'MIN': 3,
-	'PENT': 4
+	'PENT': 4,
+	'USER': 5
 };
 
 var range_types = {
@@ -115,11 +131,13 @@ function setup() {
 	waveType = createRadio();
 	waveType.option('SAW');
 	waveType.option('SQUARE');
+	waveType.option('USER');
 	waveType.selected('SAW');
 	
 	waveType2 = createRadio();
 	waveType2.option('SAW');
 	waveType2.option('SQUARE');
+	waveType2.option('USER');
 	waveType2.selected('SAW');
 	
 	scale = createRadio();
@@ -129,6 +147,7 @@ function setup() {
 	scale.option('MAJ');
 	scale.option('MIN');
 	scale.option('PENT');
+	scale.option('USER');
 	scale.selected('None');
 	
 	seqRange = createRadio();
@@ -167,6 +186,8 @@ function setup() {
 	r4s2 = createCheckbox('SEQ 2', false);
 	r4s2.changed(checkBoxEvent);
 
+	PcpuReport = createP("");
+
 	//This function will format colors and positions of the DOM elements (sliders, button and text)
 	formatDOMElements();
 }
@@ -260,9 +281,68 @@ function draw() {
 	buffer[rhythmDivsOffset+2]=rhythm3.value();
 	buffer[rhythmDivsOffset+3]=rhythm4.value();
 	
-	//send buffer to audio application
-	Bela.data.sendBuffer(0, 'float', buffer);
+	//send changes to audio application
+	receiveAck();
+	sendChanges();
+	
+	showCpuReport();
+}
 
+//show the latest CPU report as percent of the block deadline, mean / p99 / max for each stage
+function showCpuReport() {
+	let report = Bela.data.buffers[1];
+	if(report === undefined || report === null || report === cpuReport || report.length < 3 + 3 * cpuStageNames.length)
+		return;
+	cpuReport = report;
+	let text = "CPU (% of deadline, mean / p99 / max) XRUNS " + report[0] + " DROPPED " + report[1] + "<br>";
+	for(let i = 0; i < cpuStageNames.length; i++) {
+		let stats = report.slice(3 + 3 * i, 6 + 3 * i).map(x => x.toFixed(1));
+		text += cpuStageNames[i] + " " + stats.join(" / ") + "<br>";
+	}
+	PcpuReport.html(text);
+}
+
+//mark the values in an acknowledged packet as applied, earlier packets are covered by it
+//every page receives every acknowledgement, so only those carrying this page's client id count
+function receiveAck() {
+	let received = Bela.data.buffers[0];
+	if(received === undefined || received === null || received.length === undefined || received.length < 2)
+		return;
+	if(received[0] !== clientId)
+		return;
+	let ackVersion = received[1];
+	let sent = inFlight[ackVersion];
+	if(sent === undefined)
+		return;
+	for(let id in sent)
+		acked[id] = sent[id];
+	for(let v in inFlight) {
+		if(Number(v) <= ackVersion)
+			delete inFlight[v];
+	}
+}
+
+//send every value that differs from what Bela has acknowledged, at most once per interval
+function sendChanges() {
+	if(millis() - lastSendTime < sendInterval)
+		return;
+	let packet = [clientId, 0, 0];
+	let sent = {};
+	for(let i = 0; i < buffer.length; i++) {
+		if(buffer[i] !== acked[i]) {
+			packet.push(i, buffer[i]);
+			sent[i] = buffer[i];
+		}
+	}
+	if(packet.length == 3)
+		return;
+	version = version % (maxVersion - 1) + 1;
+	packet[1] = version;
+	packet[2] = (packet.length - 3) / 2;
+	packet.push(version);
+	inFlight[version] = sent;
+	Bela.data.sendBuffer(0, 'float', packet);
+	lastSendTime = millis();
 }
 
 function formatDOMElements() {
@@ -364,5 +444,7 @@ function formatDOMElements() {
 	r2s2.position(startRhythmW + 1*(rhythm1.width+s), startRhythmH + sh + 30);
 	r3s2.position(startRhythmW + 2*(rhythm1.width+s), startRhythmH + sh + 30);
 	r4s2.position(startRhythmW + 3*(rhythm1.width+s), startRhythmH + sh + 30);
+	
+	PcpuReport.position(startSeq1W, startRhythmH + 2 * sh + 50);
 }
 